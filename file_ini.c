@@ -6,19 +6,247 @@
 * @date 2014-12-10
 */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/file.h>
 #include <fcntl.h>
 #include <unistd.h>
 
 #include <stdint.h>
 #include <errno.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "file_ini.h"
 
+#define FI_BLANK(c)       (((c) == ' ') || ((c) == '\t'))
+#define FI_LIST_ESCAPED(s, n, i) (((s)[i] == FI_LIST_ESCAPE) && ((i) + 1 < (n)) && (((s)[(i) + 1] == FI_LIST_SEPARATOR) || ((s)[(i) + 1] == FI_LIST_ESCAPE)))
+#define FI_FOLD(c)        ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) | 0x20) : (c)) // ASCII only
+
+typedef struct STRUCT_INI_ORDER {
+    stFIProperty **item;
+    size_t         count;
+    size_t         size;
+} stFIOrder;
+
+#define FI_ORDER_GROW     64
+
+typedef struct STRUCT_INI_HASH {
+    stFINode **slot;   // Open addressing, linear probing
+    size_t     mask;
+    size_t     count;
+    uint32_t   flags;  // FI_OPT_NOCASE of the handle
+} stFIHash;
+
+typedef struct STRUCT_INI_LIST {
+    const char *val;                     // Value and version the spans were split from
+    uint32_t    version;
+    size_t      count;
+    stFISpan    span[];
+} stFIList;
+
+typedef struct STRUCT_INI_TREE_NODE {
+    struct STRUCT_INI_TREE_NODE *parent;
+    struct STRUCT_INI_TREE_NODE *child;  // First child, siblings follow in insertion order
+    struct STRUCT_INI_TREE_NODE *last;
+    struct STRUCT_INI_TREE_NODE *next;
+    stFISection *sect;                   // NULL : path without a section of its own
+    stFIHash    *view;                   // fiGetInherited() : keys of the section and its ancestors
+    uint32_t     hash;                   // fiHash() of the path
+    size_t       lenPath;
+    char         path[];
+} stFITreeNode;
+
+typedef struct STRUCT_INI_TREE {
+    stFITreeNode **slot;                 // Open addressing by path, linear probing
+    size_t         mask;
+    size_t         count;
+    stFITreeNode  *child;                // Top level paths
+    stFITreeNode  *last;
+    char           separator;
+    uint32_t       flags;                // FI_OPT_NOCASE of the handle
+    uint64_t       epoch;                // Handle epoch the tree was built for
+} stFITree;
+
+typedef struct STRUCT_INI_LOADER {
+    const char  *path;
+    char       **name;
+    stFIHandle **hIni;
+    size_t       count;
+    size_t       next;
+} stFILoader;
+
+typedef struct STRUCT_INI_READER {
+    stFIHandle  *hIni;
+    stFISection *sect;                   // Section of the following properties
+    char        *line;                   // Line under assembly(buffer or heap)
+    size_t       szLine;
+    size_t       lenLine;
+    int          cr;                     // Last chunk ended with CR
+    char         buffer[FI_BUFFER_SIZE];
+
+    stFIOption  *opt;
+    size_t       lineNo;
+    uint8_t     *seen;                   // Schema rules met in the input
+
+    int          error;                  // First fatal error, stops the parse
+    int          bom;                    // UTF-8 BOM bytes matched, -1 once past it
+    size_t       offset;                 // Input bytes consumed
+    size_t       lineStart;              // Input offset of the line under assembly
+    size_t       heap;                   // maxHeap : bytes charged so far
+    size_t       seqStart;               // FI_OPT_UTF8 : offset of the open multibyte sequence
+    uint8_t      need;                   // FI_OPT_UTF8 : continuation bytes still expected
+    uint8_t      lo;                     // FI_OPT_UTF8 : range of the next continuation byte
+    uint8_t      hi;
+
+    const stFIEvents *events;            // fiParseStream() : events instead of a tree
+    void             *ctx;
+    char             *sectName;          // fiParseStream() : current section name
+    size_t            szSect;
+    size_t            lenSect;
+} stFIReader;
+
+typedef struct STRUCT_INI_SCHEMA_RULE {
+    char     *sect;
+    size_t    lenSect;
+    uint32_t  hashSect;
+    char     *key;                       // NULL : section rule
+    size_t    lenKey;
+    uint32_t  hashKey;
+
+    int       type;
+    uint32_t  flags;
+    char     *def;
+    double    min;
+    double    max;
+} stFISchemaRule;
+
+#define FI_SCHEMA_OPEN    0x80000000 // Section declared on its own, any key is allowed
+
+struct STRUCT_INI_SCHEMA {
+    uint32_t        flags;
+    size_t          count;
+    stFISchemaRule *rule;
+    size_t          mask;
+    size_t         *slot;                // Rule index + 1, 0 : empty
+};
+
+typedef struct STRUCT_INI_RESOLVED {
+    uint64_t       epoch;   // Handle epoch at resolution time
+    size_t         count;   // Properties the value was built from(self first)
+    stFIProperty **dep;
+    uint32_t      *version;
+    char          *val;
+    size_t         lenVal;
+} stFIResolved;
+
+#define FI_RESOLVE_DEPTH  16
+#define FI_RESOLVE_REF    256
+
+typedef struct STRUCT_INI_RESOLVER {
+    stFIHandle    *hIni;
+    stFIProperty  *stack[FI_RESOLVE_DEPTH];
+    size_t         depth;
+
+    stFIProperty **dep;
+    uint32_t      *version;
+    size_t         count;
+    size_t         szDep;
+
+    char          *ptr;
+    size_t         length;
+    size_t         size;
+    int            error;
+} stFIResolver;
+
+uint64_t fiEpoch = 0;
+
+#define fiNextEpoch()     __atomic_add_fetch(&fiEpoch, 1, __ATOMIC_RELAXED)
+
+#define FI_SHM_MAGIC      0x494E4931 // "INI1"
+#define FI_SHM_NAME       256
+
+typedef struct STRUCT_INI_SHM_CTRL {
+    uint32_t magic;
+    uint32_t reserve;
+    uint64_t generation;
+} stFIShmCtrl;
+
+typedef struct STRUCT_INI_SHM_HEADER {
+    uint32_t magic;
+    uint32_t countSect;
+    uint64_t generation;
+    uint64_t size;
+} stFIShmHeader;
+
+typedef struct STRUCT_INI_SHM_ENTRY {
+    uint32_t offName;  // Section name or key
+    uint32_t lenName;
+    uint32_t offData;  // Section : first key entry, key : value
+    uint32_t lenData;  // Section : key count,       key : value length
+} stFIShmEntry;
+
+struct STRUCT_INI_SHM {
+    char           name[FI_SHM_NAME];
+    stFIShmCtrl   *ctrl;
+    stFIShmHeader *image;
+    size_t         size;
+    uint64_t       generation;
+};
+
+typedef struct STRUCT_INI_CACHE {
+    dev_t       dev;
+    ino_t       ino;
+    off_t       size;
+    uint64_t    mtime;  // ns
+    uint64_t    hash;   // FI_CACHE_HASH only
+    stFIHandle *hIni;
+
+    struct STRUCT_INI_CACHE *next;
+} stFICache;
+
+pthread_mutex_t fiCacheLock  = PTHREAD_MUTEX_INITIALIZER;
+stFICache      *fiCacheHead  = NULL;
+uint32_t        fiCacheFlags = 0;
+stFICacheStat   fiCacheCount = { 0, 0, 0 };
+
+#define FI_JOURNAL_MAGIC  0x4A524E4C // "JRNL"
+
+typedef struct STRUCT_INI_JOURNAL {
+    int       fd;
+    uint32_t  flags;
+    char     *file;      // Base ini file
+} stFIJournal;
+
+typedef struct STRUCT_INI_JOURNAL_RECORD {
+    uint32_t magic;
+    uint32_t lenSect;
+    uint32_t lenKey;
+    uint32_t lenVal;
+    uint32_t check;      // fiHash() of the payload, a torn tail fails it
+} stFIJournalRecord;
+
+typedef struct STRUCT_INI_WRITER {
+    int     fd;
+    char   *ptr;
+    size_t  size;
+    size_t  used;
+    size_t  total;
+    int     error;
+} stFIWriter;
+
 #if defined(ENABLE_LOG_TRACE)
   #include "log_trace.h"
 
@@ -107,45 +335,103 @@ stFIHandle *fiInit(void)
         lErr("Allocate failed...");
     }
     else {
-        hIni->head = NULL;
-        hIni->tail = NULL;
+        hIni->head  = NULL;
+        hIni->tail  = NULL;
+        hIni->order = NULL;
+        hIni->hash  = NULL;
+        hIni->count = 0;
+        hIni->flags = 0;
+
+        hIni->journal = NULL;
+        hIni->tree    = NULL;
+        hIni->epoch = fiNextEpoch();
     }
 
     return hIni;
 }
 
-void fiDestroy(stFIHandle *hIni)
+void fiDropIndex(stFIHandle *hIni)
 {
-    stFINode     *head = NULL;
-    stFISection  *sect = NULL;
-    stFIProperty *prop = NULL;
+    if (hIni->order) {
+        free(hIni->order->item);
+        free(hIni->order);
+        hIni->order = NULL;
+    }
 
-    if (hIni) {
-        while ( (head = (stFINode *)hIni->head) != NULL) {
-            switch(head->cfg.type) {
-            case E_INI_T_SECTION  :
-                sect = (stFISection *)head->value;
-                if (sect->name) { free(sect->name); }
+    if (hIni->hash) {
+        free(hIni->hash->slot);
+        free(hIni->hash);
+        hIni->hash = NULL;
+    }
+}
 
-                fiDestroy(sect->hIni);
-                free(sect);
-                break;
+void fiDestroySection(stFISection *sect)
+{
+    if (__atomic_sub_fetch(&sect->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        if (sect->name) { free(sect->name); }
 
-            case E_INI_T_PROPERTY :
-                prop = (stFIProperty *)head->value;
-                if (prop->key) { free(prop->key); }
-                if (prop->val) { free(prop->val); }
+        fiDestroy(sect->hIni);
+        free(sect);
+    }
+}
 
-                free(prop);
-                break;
+void fiDestroyValue(int type, void *value)
+{
+    stFIProperty *prop = NULL;
 
-            case E_INI_T_UNKNOWN  :
-            case E_INI_T_BLANK    :
-            case E_INI_T_COMMENT  :
-            default               :
-                if (head->value) { free(head->value); }
-                break;
+    switch(type) {
+    case E_INI_T_SECTION  :
+        fiDestroySection((stFISection *)value);
+        break;
+
+    case E_INI_T_PROPERTY :
+        prop = (stFIProperty *)value;
+        if (prop->key)      { free(prop->key); }
+        if (prop->val)      { free(prop->val); }
+        if (prop->resolved) { free(prop->resolved); }
+        if (prop->list)     { free(prop->list); }
+
+        free(prop);
+        break;
+
+    case E_INI_T_UNKNOWN  :
+    case E_INI_T_BLANK    :
+    case E_INI_T_COMMENT  :
+    default               :
+        if (value) { free(value); }
+        break;
+    }
+}
+
+void fiTreeFree(stFITree *tree)
+{
+    size_t idx = 0;
+
+    if (tree) {
+        for (idx = 0; (tree->slot != NULL) && (idx <= tree->mask); idx++) {
+            if (tree->slot[idx] == NULL) {
+                continue;
+            }
+
+            if (tree->slot[idx]->view) {
+                free(tree->slot[idx]->view->slot);
+                free(tree->slot[idx]->view);
             }
+            free(tree->slot[idx]);
+        }
+
+        if (tree->slot) { free(tree->slot); }
+        free(tree);
+    }
+}
+
+void fiDestroy(stFIHandle *hIni)
+{
+    stFINode *head = NULL;
+
+    if (hIni) {
+        while ( (head = (stFINode *)hIni->head) != NULL) {
+            fiDestroyValue(head->cfg.type, head->value);
 
             hIni->head = (stFINode *)head->next;
             if ( hIni->head ) {
@@ -155,6 +441,10 @@ void fiDestroy(stFIHandle *hIni)
             free(head);
         }
 
+        fiDropIndex(hIni);
+        fiJournalClose(hIni);
+        fiTreeFree(hIni->tree);
+
         free(hIni);
     }
 }
@@ -204,6 +494,10 @@ void *fiMakeSection(const char *str, size_t size)
         lErr("Allocate failed...");
     }
     else {
+        sect->name    = NULL;
+        sect->lenName = size;
+        sect->refs    = 1;
+
         if (size > 0) {
             sect->name = (char *)malloc( size + 1 );
             if ( sect->name == NULL ) {
@@ -226,6 +520,7 @@ void *fiMakeSection(const char *str, size_t size)
             if (size > 0) {
                 snprintf(sect->name, size + 1, "%s", str);
             }
+            sect->hash = fiHash(sect->name, size);
             sect->hIni->head = NULL;
             sect->hIni->tail = NULL;
         }
@@ -245,8 +540,15 @@ void *fiMakeProperty(const char *key, char *value)
         lErr("Allocate failed...");
     }
     else {
-        prop->key = NULL;
-        prop->val = NULL;
+        prop->key      = NULL;
+        prop->val      = NULL;
+        prop->lenKey   = 0;
+        prop->lenVal   = 0;
+        prop->hash     = 0;
+        prop->version  = 0;
+        prop->resolved = NULL;
+        prop->list     = NULL;
+        prop->type     = E_INI_V_STRING;
 
         if (key == NULL) {
             lWrn("Porpery key is Not exist!!!");
@@ -264,6 +566,8 @@ void *fiMakeProperty(const char *key, char *value)
             }
             else {
                 snprintf(prop->key, length, "%s", key);
+                prop->lenKey = length - 1;
+                prop->hash   = fiHash(prop->key, prop->lenKey);
 
                 if (value) {
                     length = strlen(value) + 1;
@@ -277,6 +581,7 @@ void *fiMakeProperty(const char *key, char *value)
                     }
                     else {
                         snprintf(prop->val, length, "%s", value);
+                        prop->lenVal = length - 1;
                     }
                 }
             }
@@ -287,52 +592,123 @@ void *fiMakeProperty(const char *key, char *value)
 }
 
 
-void *fiMakePropertyFromString(char *str, size_t size)
+/* Resolves the escapes of a quoted value in place, returns its length or -1 without a closing quote */
+size_t fiUnquote(char *str, size_t size)
 {
+    size_t offset = 0,
+           length = 0;
 
-    size_t offHead = 0,
-           offTail = 0;
+    for (offset = 0; offset < size; offset++) {
+        if (str[offset] == '"') {
+            return length;
+        }
 
-    char *key    = NULL,
-         *val    = NULL,
-         *equals = NULL;
+        if ( (str[offset] == '\\') && (offset + 1 < size) ) {
+            offset = offset + 1;
+            switch(str[offset]) {
+            case 'n'  : str[length++] = '\n'; break;
+            case 'r'  : str[length++] = '\r'; break;
+            case 't'  : str[length++] = '\t'; break;
+            case '"'  :
+            case '\\' : str[length++] = str[offset]; break;
+            default   : // Unknown escape kept as written
+                str[length++] = '\\';
+                str[length++] = str[offset];
+                break;
+            }
+        }
+        else {
+            str[length++] = str[offset];
+        }
+    }
 
-    stFIProperty *prop = NULL;
+    return (size_t)-1;
+}
 
-    if (str == NULL) {
-        lWrn("Ini Property string is not exist!!!");
+/* Key and value spans of a property line, terminated in place */
+int fiTokenProperty(char *str, size_t size, stFISpan *key, stFISpan *val)
+{
+    size_t offHead = 0,
+           offTail = 0,
+           offset  = 0;
+
+    char *equals = NULL;
+
+    equals = memchr(str, '=', size);
+    if (equals == NULL) {
+        return -EINVAL;
     }
-    else {
-        equals = strchr(str, '=');
 
-        // Parsing Ini Property Key
-        offHead = 0;
-        offTail = (size_t)(equals - str);
+    // Parsing Ini Property Key, offTail is exclusive
+    offHead = 0;
+    offTail = (size_t)(equals - str);
 
-        while( (offHead < offTail) && (str[offHead] == ' ')) {
-            offHead = offHead + 1;
-        }
+    while( (offHead < offTail) && FI_BLANK(str[offHead]) ) {
+        offHead = offHead + 1;
+    }
+    while( (offHead < offTail) && FI_BLANK(str[offTail - 1]) ) {
+        offTail = offTail - 1;
+    }
+    str[offTail] = 0x00;
 
-        do {
-            str[offTail--] = 0x00;
-        } while( (offHead < offTail) && (str[offTail] == ' ') );
+    key->str = &str[offHead];
+    key->len = offTail - offHead;
 
-        if (offHead < offTail) key = (char *)&str[offHead];
+    // Parsing Ini Property value
+    offHead = (size_t)(equals - str) + 1;
+    offTail = size;
 
-        // Parsing Ini Property value
-        offHead = (size_t)(equals - str) + 1;
-        offTail = size;
+    while( (offHead < offTail) && FI_BLANK(str[offHead]) ) {
+        offHead = offHead + 1;
+    }
 
-        while( (offHead < offTail) && (str[offHead] == ' ')) {
-            offHead = offHead + 1;
+    if ( (offHead < offTail) && (str[offHead] == '"') ) {
+        // Quoted, unescaped in place; text after the closing quote is ignored
+        offHead = offHead + 1;
+        offTail = fiUnquote(&str[offHead], offTail - offHead);
+        if (offTail == (size_t)-1) {
+            lWrn("Quoted value is not closed!!!");
+            return -EINVAL;
         }
-        while( (offHead < offTail) && (str[offTail] == ' ') ) {
-            str[offTail--] = 0x00;
+        offTail = offHead + offTail;
+    }
+    else {
+        // Unquoted, used in place up to an inline comment : ';' or '#' first or after a blank
+        for (offset = offHead; offset < offTail; offset++) {
+            if ( ((str[offset] == ';') || (str[offset] == '#'))
+              && ((offset == offHead) || FI_BLANK(str[offset - 1])) ) {
+                offTail = offset;
+                break;
+            }
         }
 
-        if (offHead < offTail) val = (char *)&str[offHead];
+        while( (offHead < offTail) && FI_BLANK(str[offTail - 1]) ) {
+            offTail = offTail - 1;
+        }
+    }
+    str[offTail] = 0x00;
+
+    val->str = &str[offHead];
+    val->len = offTail - offHead;
+
+    return (key->len > 0) ? 0 : -EINVAL;
+}
+
+void *fiMakePropertyFromString(char *str, size_t size)
+{
+    stFISpan key,
+             val;
 
-        prop = (stFIProperty *)fiMakeProperty((const char *)key, val);
+    stFIProperty *prop = NULL;
+
+    if (str == NULL) {
+        lWrn("Ini Property string is not exist!!!");
+    }
+    else if (fiTokenProperty(str, size, &key, &val) != 0) {
+        lWrn("Ini Property string is invalid!!!");
+    }
+    else {
+        prop = (stFIProperty *)fiMakeProperty(key.str, (val.len > 0) ? (char *)val.str : NULL);
     }
 
     return prop;
@@ -358,674 +734,5065 @@ void *fiMakeCommand(const char *str, size_t size)
     return ptr;
 }
 
-int fiInsertNode(stFIHandle *hIni, stFINode *node)
+int fiOrderCompare(const char *a, size_t lenA, const char *b, size_t lenB)
 {
-    int ret = 0;
-
-    stFINode *tail = NULL;
+    int ret = memcmp(a, b, (lenA < lenB) ? lenA : lenB);
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
-    }
-    else if (node == NULL) {
-        lWrn("Is Not exist Insert Ini Node!!!");
-        ret = -EINVAL;
+    if (ret == 0) {
+        ret = (lenA > lenB) - (lenA < lenB);
     }
-    else {
-        tail = (stFINode *)hIni->tail;
 
-        node->front = tail;
+    return ret;
+}
 
-        if (hIni->head == NULL) {
-            hIni->head = node;
-        }
+int fiOrderSort(const void *a, const void *b)
+{
+    const stFIProperty *propA = *(const stFIProperty **)a,
+                       *propB = *(const stFIProperty **)b;
 
-        if (tail != NULL) {
-            tail->next = node;
+    return fiOrderCompare(propA->key, propA->lenKey, propB->key, propB->lenKey);
+}
+
+/* First slot whose key is not less than str, or greater than str when upper is set.
+ * With prefix set, keys are cut to the length of str before comparing. */
+size_t fiOrderBound(stFIOrder *order, const char *str, size_t len, int upper, int prefix)
+{
+    size_t low  = 0,
+           high = order->count,
+           mid  = 0,
+           lenKey = 0;
+
+    int cmp = 0;
+
+    while (low < high) {
+        mid    = low + ((high - low) >> 1);
+        lenKey = order->item[mid]->lenKey;
+        if ( prefix && (lenKey > len) ) {
+            lenKey = len;
         }
 
-        hIni->tail = node;
+        cmp = fiOrderCompare(order->item[mid]->key, lenKey, str, len);
+        if ( (cmp < 0) || (upper && (cmp == 0)) ) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
     }
 
-    return ret;
+    return low;
 }
 
-int fiInsert(stFIHandle *hIni, int type, const char *str, size_t size)
+int fiOrderInsert(stFIOrder *order, stFIProperty *prop)
 {
     int ret = 0;
 
-    stFINode *node  = NULL;
-    void     *value = NULL;
+    size_t pos = 0;
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
-    }
-    else {
-        switch(type) {
-        case E_INI_T_SECTION  :
-            value = fiMakeSection(str, size);
-            if (value == NULL) {
-                lWrn("fiMakeSection() failed!!!");
-                ret = -EFAULT;
-            }
-            break;
-        case E_INI_T_PROPERTY :
-            value = fiMakePropertyFromString((char *)str, size);
-            if (value == NULL) {
-                lWrn("fiMakePropertyFromString() failed!!!");
-                ret = -EFAULT;
-            }
-            break;
-        case E_INI_T_COMMENT  :
-            value = fiMakeCommand(str, size);
-            if (value == NULL) {
-                lWrn("fiMakeSection() failed!!!");
-                ret = -EFAULT;
-            }
-            break;
-        case E_INI_T_BLANK    : break;
-        case E_INI_T_UNKNOWN  :
-        default               :
-            lWrn("Not support type...%d", type);
-            ret = -EINVAL;
-            break;
-        }
-    }
+    stFIProperty **item = NULL;
 
-    if (ret >= 0) {
-        node = (stFINode *)malloc(sizeof(stFINode));
-        if (node == NULL) {
+    if (order->count == order->size) {
+        item = (stFIProperty **)realloc(order->item, (order->size + FI_ORDER_GROW) * sizeof(stFIProperty *));
+        if (item == NULL) {
             lErr("Allocate failed...");
-            if (value != NULL) { free(value); }
-            ret = -EFAULT;
+            ret = -ENOMEM;
         }
         else {
-            node->cfg.type = type;
+            order->item = item;
+            order->size = order->size + FI_ORDER_GROW;
+        }
+    }
 
-            node->value = value;
-            node->front = NULL;
-            node->next  = NULL;
+    if (ret == 0) {
+        pos = fiOrderBound(order, prop->key, prop->lenKey, 1, 0);
+        memmove(&order->item[pos + 1], &order->item[pos], (order->count - pos) * sizeof(stFIProperty *));
 
-            ret = fiInsertNode(hIni, node);
-        }
+        order->item[pos] = prop;
+        order->count     = order->count + 1;
     }
 
     return ret;
 }
 
-int fiInsertComment(stFIHandle *hIni, char *str, size_t size)
+stFIOrder *fiOrderBuild(stFIHandle *hIni)
 {
-    int ret = 0;
-
-    size_t offset = 0;
-
-    char *tok = NULL,
-         *old = NULL;
+    size_t count = 0;
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
-    }
-    else if (str == NULL) {
-        lWrn("Text line is empty!!!");
-        ret = -EINVAL;
-    }
-    else {
-        tok = strtok_r(str, "#;", &old);
-        if ( tok ) {
-            offset = tok - str;
-//              lDbg("%s() %s[Offset=(%d, L=%d, O=%d)",
-//                  __FUNCTION__, tok, (int)(tok - str), (int)strlen(tok), (int)(old - str));
+    stFINode  *head  = NULL;
+    stFIOrder *order = NULL;
 
-            while( (offset < size) && (str[offset] == ' ')) {
-                offset = offset + 1;
-            }
+    if (hIni->order == NULL) {
+        for (head = hIni->head; head != NULL; head = head->next) {
+            if (head->cfg.type == E_INI_T_PROPERTY) { count = count + 1; }
+        }
 
-            if (offset < size) {
-                ret = fiInsert(hIni, E_INI_T_COMMENT, &str[offset], strlen(&str[offset]));
+        order = (stFIOrder *)malloc(sizeof(stFIOrder));
+        if (order == NULL) {
+            lErr("Allocate failed...");
+        }
+        else {
+            order->count = 0;
+            order->size  = count + FI_ORDER_GROW;
+            order->item  = (stFIProperty **)malloc(order->size * sizeof(stFIProperty *));
+            if (order->item == NULL) {
+                lErr("Allocate failed...");
+                free(order);
+                order = NULL;
             }
             else {
-                lWrn("Comment is empty!!!");
-                ret = 0;
+                for (head = hIni->head; head != NULL; head = head->next) {
+                    if (head->cfg.type == E_INI_T_PROPERTY) {
+                        order->item[order->count++] = (stFIProperty *)head->value;
+                    }
+                }
+
+                qsort(order->item, order->count, sizeof(stFIProperty *), fiOrderSort);
+                hIni->order = order;
             }
         }
     }
 
-    return ret;
+    return hIni->order;
 }
 
-stFISection *fiFindSection(stFIHandle *hIni, const char *key)
+uint32_t fiHash(const char *str, size_t size)
 {
-    size_t lenKey = 0;
-    stFISection *sect   = NULL,
-                *fiSect = NULL;
+    uint32_t hash = 0x811C9DC5;
 
-    stFINode    *head = NULL,
-                *next = NULL;
+    size_t idx = 0;
 
-    if (hIni) {
-        lenKey = strlen(key);
+    for (idx = 0; idx < size; idx++) {
+        hash = (hash ^ (uint8_t)str[idx]) * 0x01000193;
+    }
 
-        head = (stFINode *)hIni->head;
-        while ( (head != NULL) && (sect == NULL) ) {
-            next = head->next;
-            if( head->cfg.type == E_INI_T_SECTION ) {
-                fiSect = (stFISection *)head->value;
+    return hash;
+}
 
-                if (fiSect->name == NULL) {
-                    if (lenKey == 0) {
-                        sect = fiSect;
-                    }
-                }
-                else {
-                    if ( (lenKey > 0)
-                      && (strcmp((const char *)fiSect->name, (const char *)key) == 0) ) {
-                        sect = fiSect;
-                    }
-                }
-            }
-            head = next;
-        }
+uint32_t fiHashFold(const char *str, size_t size)
+{
+    uint32_t hash = 0x811C9DC5;
+
+    size_t idx = 0;
 
+    for (idx = 0; idx < size; idx++) {
+        hash = (hash ^ (uint8_t)FI_FOLD(str[idx])) * 0x01000193;
     }
 
-    return sect;
+    return hash;
 }
 
-stFISection *fiSearchSection(stFIHandle *hIni, const char *key)
+/* Hash of a name as stored by a handle with flags */
+uint32_t fiHashName(uint32_t flags, const char *str, size_t size)
 {
-    stFINode    *node = NULL;
-    stFISection *sect = NULL;
-
-    if (hIni) {
-        sect = fiFindSection(hIni, key);
-        if (sect == NULL) {
-            sect = fiMakeSection(key, strlen(key));
-            if (sect == NULL) {
-                lWrn("fiMakeSection() failed!!!");
-            }
-            else {
-                node = (stFINode *)malloc(sizeof(stFINode));
-                if (node == NULL) {
-                    lErr("Allocate failed...");
-                    if (sect != NULL) {
-                        free(sect);
-                        sect = NULL;
-                    }
-                }
-                else {
-                    node->cfg.type = E_INI_T_SECTION;
+    return (flags & FI_OPT_NOCASE) ? fiHashFold(str, size) : fiHash(str, size);
+}
 
-                    node->value = sect;
-                    node->front = NULL;
-                    node->next  = NULL;
+/* Called once hash and length already match */
+int fiNameEqual(uint32_t flags, const char *a, const char *b, size_t size)
+{
+    size_t idx = 0;
 
-                    fiInsertNode(hIni, node);
+    if ( (flags & FI_OPT_NOCASE) == 0 ) {
+        return memcmp(a, b, size) == 0;
+    }
 
-                }
-            }
+    for (idx = 0; idx < size; idx++) {
+        if (FI_FOLD(a[idx]) != FI_FOLD(b[idx])) {
+            return 0;
         }
     }
 
-    return sect;
+    return 1;
 }
 
-int fiInsertSection(stFIHandle *hIni, char *str, size_t size)
+/* Name and hash of a section or property node */
+int fiNodeKey(stFINode *node, const char **key, size_t *size, uint32_t *hash)
 {
     int ret = 0;
 
-    char *tok = NULL,
-         *old = NULL;
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL;
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
-    }
-    else if (str == NULL) {
-        lWrn("Text line is empty!!!");
-        ret = -EINVAL;
-    }
-    else {
-        tok = strtok_r(str, "[]", &old);
-        if ( tok ) {
-            if (fiSearchSection(hIni, tok) == NULL) {
-                ret = -EFAULT;
-            }
-        }
+    switch(node->cfg.type) {
+    case E_INI_T_SECTION  :
+        sect  = (stFISection *)node->value;
+        *key  = (sect->name) ? sect->name : "";
+        *size = sect->lenName;
+        *hash = sect->hash;
+        break;
+
+    case E_INI_T_PROPERTY :
+        prop  = (stFIProperty *)node->value;
+        *key  = prop->key;
+        *size = prop->lenKey;
+        *hash = prop->hash;
+        break;
+
+    default               : ret = -EINVAL; break;
     }
 
     return ret;
 }
 
-int fiInsertProperty(stFIHandle *hIni, char *str, size_t size)
+/* Adds node unless an equal key is indexed already, the first one wins like the list walk */
+void fiHashAdd(stFIHash *hash, stFINode *node)
 {
-    int ret = 0;
+    size_t idx = 0,
+           size = 0,
+           lenSlot = 0;
 
-    stFISection *sect = NULL;
+    uint32_t value = 0,
+             hashSlot = 0;
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
+    const char *key  = NULL,
+               *slot = NULL;
+
+    if (fiNodeKey(node, &key, &size, &value) == 0) {
+        for (idx = value & hash->mask; hash->slot[idx] != NULL; idx = (idx + 1) & hash->mask) {
+            fiNodeKey(hash->slot[idx], &slot, &lenSlot, &hashSlot);
+            if ( (hashSlot == value) && (lenSlot == size) && fiNameEqual(hash->flags, slot, key, size) ) {
+                return;
+            }
+        }
+
+        hash->slot[idx] = node;
+        hash->count     = hash->count + 1;
+    }
+}
+
+int fiHashResize(stFIHandle *hIni, size_t count)
+{
+    int ret = 0;
+
+    size_t size = FI_HASH_MIN << 1;
+
+    stFINode *head = NULL;
+    stFIHash *hash = NULL;
+
+    while (size < (count << 1)) {
+        size = size << 1;
+    }
+
+    hash = (stFIHash *)malloc(sizeof(stFIHash));
+    if (hash == NULL) {
+        lErr("Allocate failed...");
+        ret = -ENOMEM;
+    }
+    else {
+        hash->slot  = (stFINode **)calloc(size, sizeof(stFINode *));
+        hash->mask  = size - 1;
+        hash->count = 0;
+        hash->flags = hIni->flags;
+        if (hash->slot == NULL) {
+            lErr("Allocate failed...");
+            free(hash);
+            ret = -ENOMEM;
+        }
+        else {
+            for (head = hIni->head; head != NULL; head = head->next) {
+                fiHashAdd(hash, head);
+            }
+
+            if (hIni->hash) {
+                free(hIni->hash->slot);
+                free(hIni->hash);
+            }
+            hIni->hash = hash;
+        }
+    }
+
+    return ret;
+}
+
+/* Index of a handle grown to FI_HASH_MIN entries, a failed build leaves lookups linear */
+void fiHashEnsure(stFIHandle *hIni)
+{
+    if ( (hIni->hash == NULL) && (hIni->count >= FI_HASH_MIN) ) {
+        fiHashResize(hIni, hIni->count);
+    }
+}
+
+/* Node of a section or property by name, through the hash index once it pays off */
+stFINode *fiHashFind(stFIHash *hash, int type, const char *key, size_t size, uint32_t value)
+{
+    size_t idx = 0,
+           lenNode = 0;
+
+    uint32_t hashNode = 0;
+
+    const char *name = NULL;
+
+    stFINode *node = NULL,
+             *head = NULL;
+
+    for (idx = value & hash->mask; hash->slot[idx] != NULL; idx = (idx + 1) & hash->mask) {
+        head = hash->slot[idx];
+        fiNodeKey(head, &name, &lenNode, &hashNode);
+        if ( (head->cfg.type == type) && (hashNode == value)
+          && (lenNode == size) && fiNameEqual(hash->flags, name, key, size) ) {
+            node = head;
+            break;
+        }
+    }
+
+    return node;
+}
+
+stFINode *fiFindNode(stFIHandle *hIni, int type, const char *key, size_t size, uint32_t hash)
+{
+    size_t lenNode = 0;
+
+    uint32_t hashNode = 0;
+
+    const char *name = NULL;
+
+    stFINode *node = NULL,
+             *head = NULL;
+
+    // Never builds the index : a lookup may run on a section shared with other threads
+    if (hIni->hash) {
+        node = fiHashFind(hIni->hash, type, key, size, hash);
+    }
+    else {
+        for (head = hIni->head; head != NULL; head = head->next) {
+            if ( (head->cfg.type == type) && (fiNodeKey(head, &name, &lenNode, &hashNode) == 0)
+              && (hashNode == hash) && (lenNode == size) && fiNameEqual(hIni->flags, name, key, size) ) {
+                node = head;
+                break;
+            }
+        }
+    }
+
+    return node;
+}
+
+/* Unlinks node from its list, the indexes of the handle are dropped and rebuilt on demand */
+void fiRemoveNode(stFIHandle *hIni, stFINode *node)
+{
+    size_t size = 0;
+
+    uint32_t hash = 0;
+
+    const char *key = NULL;
+
+    int indexed = 1;
+
+    // A later duplicate is not in the hash index, removing it keeps the index
+    if ( hIni->hash && (fiNodeKey(node, &key, &size, &hash) == 0) ) {
+        indexed = (fiHashFind(hIni->hash, node->cfg.type, key, size, hash) == node);
+    }
+
+    if (node->front) { ((stFINode *)node->front)->next = node->next; }
+    else             { hIni->head = node->next; }
+
+    if (node->next)  { ((stFINode *)node->next)->front = node->front; }
+    else             { hIni->tail = node->front; }
+
+    node->front = NULL;
+    node->next  = NULL;
+
+    if ( (node->cfg.type == E_INI_T_SECTION) || (node->cfg.type == E_INI_T_PROPERTY) ) {
+        hIni->count = hIni->count - 1;
+        if (indexed) {
+            fiDropIndex(hIni);
+        }
+        else if (hIni->order) {
+            free(hIni->order->item);
+            free(hIni->order);
+            hIni->order = NULL;
+        }
+    }
+}
+
+/* Rehashes the names of a section for the mode of the handle it moves to */
+void fiSectionRehash(stFISection *sect, uint32_t flags)
+{
+    stFINode     *head = NULL;
+    stFIProperty *prop = NULL;
+
+    sect->hash        = fiHashName(flags, (sect->name) ? sect->name : "", sect->lenName);
+    sect->hIni->flags = (sect->hIni->flags & ~FI_OPT_NOCASE) | (flags & FI_OPT_NOCASE);
+
+    for (head = sect->hIni->head; head != NULL; head = head->next) {
+        if (head->cfg.type == E_INI_T_PROPERTY) {
+            prop       = (stFIProperty *)head->value;
+            prop->hash = fiHashName(flags, prop->key, prop->lenKey);
+        }
+    }
+
+    fiDropIndex(sect->hIni);
+    fiHashEnsure(sect->hIni);
+}
+
+/* Node entering a FI_OPT_NOCASE handle gets its folded hash */
+void fiNodeFold(stFIHandle *hIni, stFINode *node)
+{
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL;
+
+    switch(node->cfg.type) {
+    case E_INI_T_SECTION  :
+        sect = (stFISection *)node->value;
+        if ( (sect->hIni->flags & FI_OPT_NOCASE) == 0 ) {
+            fiSectionRehash(sect, hIni->flags);
+        }
+        else if (sect->hash != fiHashFold(sect->name, sect->lenName)) {
+            // Already folded when it is shared, so a clone does not write it
+            sect->hash = fiHashFold(sect->name, sect->lenName);
+        }
+        break;
+
+    case E_INI_T_PROPERTY :
+        prop       = (stFIProperty *)node->value;
+        prop->hash = fiHashFold(prop->key, prop->lenKey);
+        break;
+
+    default               : break;
+    }
+}
+
+int fiInsertNode(stFIHandle *hIni, stFINode *node)
+{
+    int ret = 0;
+
+    stFINode *tail = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if (node == NULL) {
+        lWrn("Is Not exist Insert Ini Node!!!");
+        ret = -EINVAL;
+    }
+    else {
+        // Rehashing for another case mode writes the section, a shared one must be fiOwnSection()ed first
+        if ( (node->cfg.type == E_INI_T_SECTION)
+          && ((((stFISection *)node->value)->hIni->flags ^ hIni->flags) & FI_OPT_NOCASE)
+          && (__atomic_load_n(&((stFISection *)node->value)->refs, __ATOMIC_ACQUIRE) > 1) ) {
+            lWrn("Shared section needs a copy!!!");
+            return -EBUSY;
+        }
+
+        if (hIni->flags & FI_OPT_NOCASE) {
+            fiNodeFold(hIni, node);
+        }
+        else if ( (node->cfg.type == E_INI_T_SECTION) && (((stFISection *)node->value)->hIni->flags & FI_OPT_NOCASE) ) {
+            fiSectionRehash((stFISection *)node->value, hIni->flags);
+        }
+
+        tail = (stFINode *)hIni->tail;
+
+        node->front = tail;
+        node->next  = NULL;
+
+        if (hIni->head == NULL) {
+            hIni->head = node;
+        }
+
+        if (tail != NULL) {
+            tail->next = node;
+        }
+
+        hIni->tail = node;
+
+        if ( (hIni->order != NULL) && (node->cfg.type == E_INI_T_PROPERTY) ) {
+            if (fiOrderInsert(hIni->order, (stFIProperty *)node->value) != 0) {
+                // Drop the index, the next range query rebuilds it
+                free(hIni->order->item);
+                free(hIni->order);
+                hIni->order = NULL;
+            }
+        }
+
+        if ( (node->cfg.type == E_INI_T_SECTION) || (node->cfg.type == E_INI_T_PROPERTY) ) {
+            hIni->count = hIni->count + 1;
+
+            if (hIni->hash == NULL) {
+                // Built by the writer once FI_HASH_MIN is reached, lookups only read it
+                fiHashEnsure(hIni);
+            }
+            else {
+                if ( ((hIni->hash->count + 1) << 1) > hIni->hash->mask ) {
+                    if (fiHashResize(hIni, hIni->count) != 0) {
+                        free(hIni->hash->slot);
+                        free(hIni->hash);
+                        hIni->hash = NULL;
+                    }
+                }
+                else {
+                    fiHashAdd(hIni->hash, node);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+int fiInsert(stFIHandle *hIni, int type, const char *str, size_t size)
+{
+    int ret = 0;
+
+    stFINode *node  = NULL;
+    void     *value = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else {
+        switch(type) {
+        case E_INI_T_SECTION  :
+            value = fiMakeSection(str, size);
+            if (value == NULL) {
+                lWrn("fiMakeSection() failed!!!");
+                ret = -EFAULT;
+            }
+            break;
+        case E_INI_T_PROPERTY :
+            value = fiMakePropertyFromString((char *)str, size);
+            if (value == NULL) {
+                lWrn("fiMakePropertyFromString() failed!!!");
+                ret = -EFAULT;
+            }
+            break;
+        case E_INI_T_COMMENT  :
+            value = fiMakeCommand(str, size);
+            if (value == NULL) {
+                lWrn("fiMakeSection() failed!!!");
+                ret = -EFAULT;
+            }
+            break;
+        case E_INI_T_BLANK    : break;
+        case E_INI_T_UNKNOWN  :
+        default               :
+            lWrn("Not support type...%d", type);
+            ret = -EINVAL;
+            break;
+        }
+    }
+
+    if (ret >= 0) {
+        node = (stFINode *)malloc(sizeof(stFINode));
+        if (node == NULL) {
+            lErr("Allocate failed...");
+            if (value != NULL) { free(value); }
+            ret = -EFAULT;
+        }
+        else {
+            node->cfg.type = type;
+
+            node->value = value;
+            node->front = NULL;
+            node->next  = NULL;
+
+            ret = fiInsertNode(hIni, node);
+        }
+    }
+
+    return ret;
+}
+
+int fiInsertComment(stFIHandle *hIni, const char *str, size_t size)
+{
+    int ret = 0;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if (str == NULL) {
+        lWrn("Text line is empty!!!");
+        ret = -EINVAL;
+    }
+    else if (size > 0) {
+        ret = fiInsert(hIni, E_INI_T_COMMENT, str, size);
+    }
+    else {
+        lWrn("Comment is empty!!!");
+    }
+
+    return ret;
+}
+
+stFINode *fiFindSectionNode(stFIHandle *hIni, const char *key)
+{
+    size_t lenKey = 0;
+
+    stFINode *node = NULL;
+
+    if (hIni) {
+        lenKey = strlen(key);
+        node   = fiFindNode(hIni, E_INI_T_SECTION, key, lenKey, fiHashName(hIni->flags, key, lenKey));
+    }
+
+    return node;
+}
+
+stFISection *fiFindSection(stFIHandle *hIni, const char *key)
+{
+    stFINode *node = fiFindSectionNode(hIni, key);
+
+    return (node) ? (stFISection *)node->value : NULL;
+}
+
+stFIProperty *fiFindProperty(stFIHandle *hIni, const char *key)
+{
+    size_t lenKey = 0;
+
+    stFINode     *node = NULL;
+    stFIProperty *prop = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else {
+        lenKey = strlen(key);
+        node   = fiFindNode(hIni, E_INI_T_PROPERTY, key, lenKey, fiHashName(hIni->flags, key, lenKey));
+        if (node) {
+            prop = (stFIProperty *)node->value;
+        }
+    }
+
+    return prop;
+}
+
+stFINode *fiInsertValue(stFIHandle *hIni, int type, void *value)
+{
+    stFINode *node = NULL;
+
+    node = (stFINode *)malloc(sizeof(stFINode));
+    if (node == NULL) {
+        lErr("Allocate failed...");
+    }
+    else {
+        node->cfg.type = type;
+
+        node->value = value;
+        node->front = NULL;
+        node->next  = NULL;
+
+        // Not linked : the caller still owns value
+        if (fiInsertNode(hIni, node) != 0) {
+            free(node);
+            node = NULL;
+        }
+    }
+
+    return node;
+}
+
+stFINode *fiSearchSectionNode(stFIHandle *hIni, const char *key)
+{
+    stFINode    *node = NULL;
+    stFISection *sect = NULL;
+
+    if (hIni) {
+        node = fiFindSectionNode(hIni, key);
+        if (node == NULL) {
+            sect = fiMakeSection(key, strlen(key));
+            if (sect == NULL) {
+                lWrn("fiMakeSection() failed!!!");
+            }
+            else {
+                node = fiInsertValue(hIni, E_INI_T_SECTION, sect);
+                if (node == NULL) {
+                    fiDestroy(sect->hIni);
+                    if (sect->name) { free(sect->name); }
+                    free(sect);
+                }
+            }
+        }
+    }
+
+    return node;
+}
+
+stFISection *fiSearchSection(stFIHandle *hIni, const char *key)
+{
+    stFINode *node = fiSearchSectionNode(hIni, key);
+
+    return (node) ? (stFISection *)node->value : NULL;
+}
+
+stFISection *fiCopySection(const stFISection *src)
+{
+    stFINode     *head = NULL;
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL;
+    void         *value = NULL;
+
+    sect = (stFISection *)fiMakeSection(src->name, src->lenName);
+    if (sect == NULL) {
+        lWrn("fiMakeSection() failed!!!");
+    }
+    else {
+        sect->hash        = src->hash;
+        sect->hIni->flags = src->hIni->flags;
+
+        for (head = src->hIni->head; (head != NULL) && (sect != NULL); head = head->next) {
+            value = NULL;
+            switch(head->cfg.type) {
+            case E_INI_T_PROPERTY :
+                prop  = (stFIProperty *)head->value;
+                value = fiMakeProperty(prop->key, prop->val);
+                if (value) {
+                    ((stFIProperty *)value)->type  = prop->type;
+                    ((stFIProperty *)value)->typed = prop->typed;
+                }
+                break;
+            case E_INI_T_COMMENT  :
+                value = fiMakeCommand((char *)head->value, strlen((char *)head->value));
+                break;
+            default               : break;
+            }
+
+            if ( ((value == NULL) && (head->cfg.type != E_INI_T_BLANK))
+              || (fiInsertValue(sect->hIni, head->cfg.type, value) == NULL) ) {
+                lWrn("Section copy failed!!!");
+                if (value) {
+                    fiDestroyValue(head->cfg.type, value);
+                }
+                fiDestroySection(sect);
+                sect = NULL;
+            }
+        }
+    }
+
+    return sect;
+}
+
+stFIHandle *fiClone(stFIHandle *hIni)
+{
+    stFINode    *head  = NULL;
+    stFIHandle  *clone = NULL;
+    stFISection *sect  = NULL;
+    void        *value = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else if ( (clone = fiInit()) == NULL ) {
+        lWrn("fiInit() failed!!!");
+    }
+    else {
+        clone->flags = hIni->flags;
+
+        for (head = hIni->head; (head != NULL) && (clone != NULL); head = head->next) {
+            value = NULL;
+            switch(head->cfg.type) {
+            case E_INI_T_SECTION  :
+                sect  = (stFISection *)head->value;
+                value = sect;
+                __atomic_add_fetch(&sect->refs, 1, __ATOMIC_RELAXED);
+                break;
+            case E_INI_T_COMMENT  :
+                value = fiMakeCommand((char *)head->value, strlen((char *)head->value));
+                break;
+            default               : break;
+            }
+
+            if ( ((value == NULL) && (head->cfg.type != E_INI_T_BLANK))
+              || (fiInsertValue(clone, head->cfg.type, value) == NULL) ) {
+                lWrn("Clone failed!!!");
+                if (value) {
+                    fiDestroyValue(head->cfg.type, value);
+                }
+                fiDestroy(clone);
+                clone = NULL;
+            }
+        }
+    }
+
+    return clone;
+}
+
+/* Makes the section of node private to its handle before a mutation */
+stFISection *fiOwnSection(stFINode *node)
+{
+    stFISection *sect = (stFISection *)node->value,
+                *copy = NULL;
+
+    if (__atomic_load_n(&sect->refs, __ATOMIC_ACQUIRE) > 1) {
+        copy = fiCopySection(sect);
+        if (copy == NULL) {
+            lWrn("fiCopySection() failed!!!");
+        }
+        else {
+            fiDestroySection(sect);
+            node->value = copy;
+        }
+        sect = copy;
+    }
+
+    return sect;
+}
+
+/**
+ * Section of sect made private to hIni before a lazy cache(list, resolved, order)
+ * is built in it. A section shared through fiClone() or the parse cache is only
+ * read, other handles may be reading it from other threads.
+ */
+stFISection *fiOwnSectionOf(stFIHandle *hIni, const char *sect)
+{
+    stFINode    *node   = NULL;
+    stFISection *fiSect = NULL;
+
+    void *shared = NULL;
+
+    node = fiFindSectionNode(hIni, sect);
+    if (node) {
+        shared = node->value;
+        fiSect = fiOwnSection(node);
+        if ( fiSect && (fiSect != shared) ) {
+            hIni->epoch = fiNextEpoch();
+        }
+    }
+
+    return fiSect;
+}
+
+stFITreeNode *fiTreeFind(stFITree *tree, const char *path, size_t size, uint32_t hash)
+{
+    size_t idx = 0;
+
+    stFITreeNode *node = NULL;
+
+    for (idx = hash & tree->mask; tree->slot[idx] != NULL; idx = (idx + 1) & tree->mask) {
+        if ( (tree->slot[idx]->hash == hash) && (tree->slot[idx]->lenPath == size)
+          && fiNameEqual(tree->flags, tree->slot[idx]->path, path, size) ) {
+            node = tree->slot[idx];
+            break;
+        }
+    }
+
+    return node;
+}
+
+int fiTreeResize(stFITree *tree, size_t size)
+{
+    int ret = 0;
+
+    size_t idx = 0,
+           pos = 0;
+
+    stFITreeNode **slot = NULL;
+
+    slot = (stFITreeNode **)calloc(size, sizeof(stFITreeNode *));
+    if (slot == NULL) {
+        lErr("Allocate failed...");
+        ret = -ENOMEM;
+    }
+    else {
+        for (idx = 0; (tree->slot != NULL) && (idx <= tree->mask); idx++) {
+            if (tree->slot[idx]) {
+                for (pos = tree->slot[idx]->hash & (size - 1); slot[pos] != NULL; pos = (pos + 1) & (size - 1));
+                slot[pos] = tree->slot[idx];
+            }
+        }
+
+        if (tree->slot) { free(tree->slot); }
+        tree->slot = slot;
+        tree->mask = size - 1;
+    }
+
+    return ret;
+}
+
+/* Node of path, created along with its missing ancestors */
+stFITreeNode *fiTreeNode(stFITree *tree, const char *path, size_t size)
+{
+    size_t idx = 0;
+
+    uint32_t hash = fiHashName(tree->flags, path, size);
+
+    stFITreeNode *node   = NULL,
+                 *parent = NULL;
+
+    node = fiTreeFind(tree, path, size, hash);
+    if (node == NULL) {
+        for (idx = size; (idx > 0) && (path[idx - 1] != tree->separator); idx--);
+
+        if (idx > 1) {
+            parent = fiTreeNode(tree, path, idx - 1);
+            if (parent == NULL) {
+                return NULL;
+            }
+        }
+
+        if ( ((tree->count + 1) << 2) > ((tree->mask + 1) * 3) ) {
+            if (fiTreeResize(tree, (tree->mask + 1) << 1) != 0) {
+                return NULL;
+            }
+        }
+
+        node = (stFITreeNode *)malloc(sizeof(stFITreeNode) + size + 1);
+        if (node == NULL) {
+            lErr("Allocate failed...");
+        }
+        else {
+            node->parent  = parent;
+            node->child   = NULL;
+            node->last    = NULL;
+            node->next    = NULL;
+            node->sect    = NULL;
+            node->view    = NULL;
+            node->hash    = hash;
+            node->lenPath = size;
+            memcpy(node->path, path, size);
+            node->path[size] = 0x00;
+
+            if (parent) {
+                if (parent->last) { parent->last->next = node; }
+                else              { parent->child      = node; }
+                parent->last = node;
+            }
+            else {
+                if (tree->last) { tree->last->next = node; }
+                else            { tree->child      = node; }
+                tree->last = node;
+            }
+
+            for (idx = hash & tree->mask; tree->slot[idx] != NULL; idx = (idx + 1) & tree->mask);
+            tree->slot[idx] = node;
+            tree->count     = tree->count + 1;
+        }
+    }
+
+    return node;
+}
+
+int fiTreeAdd(stFITree *tree, stFISection *sect)
+{
+    int ret = 0;
+
+    stFITreeNode *node = NULL;
+
+    if (sect->lenName > 0) {
+        node = fiTreeNode(tree, sect->name, sect->lenName);
+        if (node == NULL) {
+            ret = -ENOMEM;
+        }
+        else if (node->sect == NULL) {
+            node->sect = sect;
+        }
+    }
+
+    return ret;
+}
+
+int fiTreeBuild(stFIHandle *hIni, char separator)
+{
+    int ret = 0;
+
+    stFINode *head = NULL;
+    stFITree *tree = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if ( (tree = (stFITree *)calloc(1, sizeof(stFITree))) == NULL ) {
+        lErr("Allocate failed...");
+        ret = -ENOMEM;
+    }
+    else {
+        tree->separator = (separator) ? separator : FI_TREE_SEPARATOR;
+        tree->flags     = hIni->flags;
+        tree->epoch     = hIni->epoch;
+
+        ret = fiTreeResize(tree, FI_HASH_MIN << 1);
+        for (head = hIni->head; (ret == 0) && (head != NULL); head = head->next) {
+            if (head->cfg.type == E_INI_T_SECTION) {
+                ret = fiTreeAdd(tree, (stFISection *)head->value);
+            }
+        }
+
+        if (ret != 0) {
+            fiTreeFree(tree);
+        }
+        else {
+            fiTreeFree(hIni->tree);
+            hIni->tree = tree;
+        }
+    }
+
+    return ret;
+}
+
+int fiInsertSection(stFIHandle *hIni, const char *str, stFISection **sect)
+{
+    int ret = 0;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if (str == NULL) {
+        lWrn("Text line is empty!!!");
+        ret = -EINVAL;
+    }
+    else {
+        *sect = fiSearchSection(hIni, str);
+        if (*sect == NULL) {
+            ret = -EFAULT;
+        }
+    }
+
+    return ret;
+}
+
+int fiInsertProperty(stFISection *sect, const char *key, char *val, stFIProperty **prop)
+{
+    int ret = 0;
+
+    *prop = (stFIProperty *)fiMakeProperty(key, val);
+    if (*prop == NULL) {
+        lWrn("fiMakeProperty() failed!!!");
+        ret = -EFAULT;
+    }
+    else if (fiInsertValue(sect->hIni, E_INI_T_PROPERTY, *prop) == NULL) {
+        fiDestroyValue(E_INI_T_PROPERTY, *prop);
+        *prop = NULL;
+        ret = -EFAULT;
+    }
+
+    return ret;
+}
+
+int fiProcType(const char *str, size_t size)
+{
+    int ret = E_INI_T_UNKNOWN;
+
+    size_t offset = 0;
+
+    while ( (offset < size) && FI_BLANK(str[offset]) ) {
+        offset = offset + 1;
+    }
+
+    // Only the first non blank character makes a comment, see fiMakePropertyFromString() for inline ones
+    if (offset == size) {
+        ret = E_INI_T_UNKNOWN;
+    }
+    else if ( (str[offset] == ';') || (str[offset] == '#') ) {
+        ret = E_INI_T_COMMENT;
+    }
+    else if ( (str[offset] == '[') && memchr(&str[offset], ']', size - offset) ) {
+        ret = E_INI_T_SECTION;
+    }
+    else if ( memchr(&str[offset], '=', size - offset) ) {
+        ret = E_INI_T_PROPERTY;
+    }
+
+    return ret;
+}
+
+/* Line to event spans, terminated in place. Malformed lines are E_INI_T_UNKNOWN */
+int fiTokenize(char *line, size_t size, stFIEvent *ev)
+{
+    size_t offset = 0,
+           offEnd = 0;
+
+    ev->type    = (size == 0) ? E_INI_T_BLANK : fiProcType(line, size);
+    ev->key.str = &line[size];
+    ev->key.len = 0;
+    ev->val.str = &line[size];
+    ev->val.len = 0;
+
+    switch(ev->type) {
+    case E_INI_T_SECTION  :
+        // First run between brackets, "[[name]]" is "name"
+        for (offset = 0; (offset < size) && (line[offset] != '['); offset++);
+        for (; (offset < size) && ((line[offset] == '[') || (line[offset] == ']')); offset++);
+        for (offEnd = offset; (offEnd < size) && (line[offEnd] != '[') && (line[offEnd] != ']'); offEnd++);
+
+        line[offEnd] = 0x00;
+        ev->sect.str = &line[offset];
+        ev->sect.len = offEnd - offset;
+        if (ev->sect.len == 0) {
+            ev->type = E_INI_T_UNKNOWN;
+        }
+        break;
+
+    case E_INI_T_PROPERTY :
+        if (fiTokenProperty(line, size, &ev->key, &ev->val) != 0) {
+            ev->type = E_INI_T_UNKNOWN;
+        }
+        break;
+
+    case E_INI_T_COMMENT  :
+        // Blanks, then the comment marks, then blanks
+        while( (offset < size) && FI_BLANK(line[offset]) ) {
+            offset = offset + 1;
+        }
+        while( (offset < size) && ((line[offset] == ';') || (line[offset] == '#')) ) {
+            offset = offset + 1;
+        }
+        while( (offset < size) && FI_BLANK(line[offset]) ) {
+            offset = offset + 1;
+        }
+
+        ev->val.str = &line[offset];
+        ev->val.len = size - offset;
+        break;
+
+    default               : break;
+    }
+
+    return ev->type;
+}
+
+uint32_t fiSchemaHash(uint32_t hashSect, uint32_t hashKey, const char *key)
+{
+    return (hashSect * 0x01000193) ^ ((key) ? hashKey : 0x5BD1E995);
+}
+
+/* Rule index of (sect, key), key NULL for the section rule, -1 if not declared */
+ssize_t fiSchemaFind(const stFISchema *schema, const char *sect, size_t lenSect, const char *key, size_t lenKey)
+{
+    size_t idx = 0;
+
+    uint32_t hashSect = fiHash(sect, lenSect),
+             hashKey  = (key) ? fiHash(key, lenKey) : 0;
+
+    stFISchemaRule *rule = NULL;
+
+    for (idx = fiSchemaHash(hashSect, hashKey, key) & schema->mask; schema->slot[idx] != 0; idx = (idx + 1) & schema->mask) {
+        rule = &schema->rule[schema->slot[idx] - 1];
+        if ( (rule->hashSect == hashSect) && (rule->lenSect == lenSect) && (memcmp(rule->sect, sect, lenSect) == 0)
+          && ((rule->key == NULL) == (key == NULL))
+          && ((key == NULL) || ((rule->hashKey == hashKey) && (rule->lenKey == lenKey) && (memcmp(rule->key, key, lenKey) == 0))) ) {
+            return (ssize_t)(schema->slot[idx] - 1);
+        }
+    }
+
+    return -1;
+}
+
+void fiSchemaDestroy(stFISchema *schema)
+{
+    size_t idx = 0;
+
+    if (schema) {
+        for (idx = 0; idx < schema->count; idx++) {
+            if (schema->rule[idx].sect) { free(schema->rule[idx].sect); }
+            if (schema->rule[idx].key)  { free(schema->rule[idx].key); }
+            if (schema->rule[idx].def)  { free(schema->rule[idx].def); }
+        }
+
+        if (schema->rule) { free(schema->rule); }
+        if (schema->slot) { free(schema->slot); }
+        free(schema);
+    }
+}
+
+int fiSchemaAdd(stFISchema *schema, const stFISchemaEntry *entry, int section)
+{
+    int ret = 0;
+
+    size_t idx = 0;
+
+    stFISchemaRule *rule = NULL;
+
+    const char *sect = (entry->sect) ? entry->sect : "";
+    const char *key  = (section) ? NULL : entry->key;
+
+    if ( (idx = fiSchemaFind(schema, sect, strlen(sect), key, (key) ? strlen(key) : 0)) != (size_t)-1 ) {
+        if (entry->key == NULL) {
+            schema->rule[idx].flags |= FI_SCHEMA_OPEN;
+        }
+    }
+    else {
+        rule = &schema->rule[schema->count];
+        memset(rule, 0, sizeof(stFISchemaRule));
+
+        rule->sect     = strdup(sect);
+        rule->lenSect  = strlen(sect);
+        rule->hashSect = fiHash(sect, rule->lenSect);
+        rule->flags    = (entry->key == NULL) ? FI_SCHEMA_OPEN : 0;
+        if (key) {
+            rule->key     = strdup(key);
+            rule->lenKey  = strlen(key);
+            rule->hashKey = fiHash(key, rule->lenKey);
+            rule->type    = entry->type;
+            rule->flags   = entry->flags;
+            rule->def     = (entry->def) ? strdup(entry->def) : NULL;
+            rule->min     = entry->min;
+            rule->max     = entry->max;
+        }
+        schema->count = schema->count + 1;
+
+        if ( (rule->sect == NULL) || (key && (rule->key == NULL)) || (entry->def && key && (rule->def == NULL)) ) {
+            lErr("Allocate failed...");
+            ret = -ENOMEM;
+        }
+        else {
+            for (idx = fiSchemaHash(rule->hashSect, rule->hashKey, key) & schema->mask;
+                 schema->slot[idx] != 0; idx = (idx + 1) & schema->mask) {
+            }
+            schema->slot[idx] = schema->count;
+        }
+    }
+
+    return ret;
+}
+
+stFISchema *fiSchemaCompile(const stFISchemaEntry *entry, size_t count, uint32_t flags)
+{
+    size_t idx = 0,
+           size = FI_HASH_MIN;
+
+    stFISchema *schema = NULL;
+
+    if ( (entry == NULL) && (count > 0) ) {
+        lWrn("Schema entry is not exist!!!");
+    }
+    else if ( (schema = (stFISchema *)calloc(1, sizeof(stFISchema))) == NULL ) {
+        lErr("Allocate failed...");
+    }
+    else {
+        // Every key entry also declares its section
+        while (size < (count << 2)) {
+            size = size << 1;
+        }
+
+        schema->flags = flags;
+        schema->mask  = size - 1;
+        schema->rule  = (stFISchemaRule *)calloc((count << 1) + 1, sizeof(stFISchemaRule));
+        schema->slot  = (size_t *)calloc(size, sizeof(size_t));
+        if ( (schema->rule == NULL) || (schema->slot == NULL) ) {
+            lErr("Allocate failed...");
+            fiSchemaDestroy(schema);
+            schema = NULL;
+        }
+
+        for (idx = 0; (idx < count) && (schema != NULL); idx++) {
+            if ( (fiSchemaAdd(schema, &entry[idx], 1) != 0)
+              || (entry[idx].key && (fiSchemaAdd(schema, &entry[idx], 0) != 0)) ) {
+                fiSchemaDestroy(schema);
+                schema = NULL;
+            }
+        }
+    }
+
+    return schema;
+}
+
+int fiValueParse(int type, const char *val, int64_t *num, double *real)
+{
+    int ret = 0;
+
+    char *end = NULL;
+
+    const char *ptr = NULL;
+
+    static const char *strTrue[]  = { "1", "true",  "yes", "on",  NULL },
+                      *strFalse[] = { "0", "false", "no",  "off", NULL };
+
+    size_t idx = 0;
+
+    if ( (val == NULL) || (val[0] == 0x00) ) {
+        ret = (type == E_INI_V_STRING) ? 0 : -EINVAL;
+    }
+    else {
+        switch(type) {
+        case E_INI_V_INT    :
+            // Decimal, hex only with an explicit 0x : a leading zero is not octal
+            ptr   = val + ( (val[0] == '-') || (val[0] == '+') );
+            errno = 0;
+            *num  = (int64_t)strtoll(val, &end, ( (ptr[0] == '0') && ((ptr[1] | 0x20) == 'x') ) ? 16 : 10);
+            ret   = ( (errno != 0) || (*end != 0x00) ) ? -EINVAL : 0;
+            break;
+
+        case E_INI_V_DOUBLE :
+            errno = 0;
+            *real = strtod(val, &end);
+            ret   = ( (errno != 0) || (*end != 0x00) ) ? -EINVAL : 0;
+            break;
+
+        case E_INI_V_BOOL   :
+            ret = -EINVAL;
+            for (idx = 0; strTrue[idx] != NULL; idx++) {
+                if (strcasecmp(val, strTrue[idx]) == 0)  { *num = 1; ret = 0; }
+                if (strcasecmp(val, strFalse[idx]) == 0) { *num = 0; ret = 0; }
+            }
+            break;
+
+        case E_INI_V_STRING :
+        default             : break;
+        }
+    }
+
+    return ret;
+}
+
+void fiSchemaReport(stFIReader *rd, size_t line, int error, const char *sect, const char *key, const char *val)
+{
+    stFIViolation violation = { line, error, sect, key, val };
+
+    rd->opt->violations = rd->opt->violations + 1;
+    if (rd->opt->report) {
+        rd->opt->report(rd->opt->ctx, &violation);
+    }
+}
+
+/* Validates and converts one property as it is parsed */
+void fiSchemaCheck(stFIReader *rd, stFISection *sect, stFIProperty *prop, size_t line)
+{
+    int ret = 0;
+
+    ssize_t idx = 0;
+
+    double value = 0.0;
+
+    const char     *name = (sect->name) ? sect->name : "";
+    stFISchemaRule *rule = NULL;
+
+    idx = fiSchemaFind(rd->opt->schema, name, sect->lenName, prop->key, prop->lenKey);
+    if (idx < 0) {
+        // Keys of an undeclared section are covered by the section violation
+        idx = fiSchemaFind(rd->opt->schema, name, sect->lenName, NULL, 0);
+        if ( (rd->opt->schema->flags & FI_SCHEMA_STRICT)
+          && (idx >= 0) && ((rd->opt->schema->rule[idx].flags & FI_SCHEMA_OPEN) == 0) ) {
+            fiSchemaReport(rd, line, -EPERM, name, prop->key, prop->val);
+        }
+    }
+    else {
+        rule = &rd->opt->schema->rule[idx];
+        rd->seen[idx] = 1;
+
+        ret = fiValueParse(rule->type, prop->val, &prop->typed.num, &prop->typed.real);
+        if (ret != 0) {
+            fiSchemaReport(rd, line, ret, name, prop->key, prop->val);
+        }
+        else {
+            switch(rule->type) {
+            case E_INI_V_INT    : value = (double)prop->typed.num; break;
+            case E_INI_V_DOUBLE : value = prop->typed.real;        break;
+            case E_INI_V_STRING : value = (double)prop->lenVal;    break;
+            default             : value = 0.0;                     break;
+            }
+
+            if ( ((rule->min != 0.0) || (rule->max != 0.0)) && (rule->type != E_INI_V_BOOL)
+              && ((value < rule->min) || (value > rule->max)) ) {
+                fiSchemaReport(rd, line, -ERANGE, name, prop->key, prop->val);
+            }
+            else {
+                prop->type = rule->type;
+            }
+        }
+    }
+}
+
+/* Inserts defaults and reports required keys the input did not have */
+void fiSchemaFinish(stFIReader *rd)
+{
+    size_t idx = 0;
+
+    stFISchemaRule *rule = NULL;
+    stFISection    *sect = NULL;
+    stFIProperty   *prop = NULL;
+
+    for (idx = 0; idx < rd->opt->schema->count; idx++) {
+        rule = &rd->opt->schema->rule[idx];
+        if ( (rule->key == NULL) || rd->seen[idx] ) {
+            continue;
+        }
+
+        if (rule->def) {
+            fiPut(rd->hIni, rule->sect, rule->key, rule->def);
+
+            sect = fiFindSection(rd->hIni, rule->sect);
+            prop = (sect) ? fiFindProperty(sect->hIni, rule->key) : NULL;
+            if (prop) {
+                fiSchemaCheck(rd, sect, prop, 0);
+            }
+        }
+        else if (rule->flags & FI_SCHEMA_REQUIRED) {
+            fiSchemaReport(rd, 0, -ENOENT, rule->sect, rule->key, NULL);
+        }
+    }
+}
+
+void fiReaderInit(stFIReader *rd, stFIHandle *hIni, stFIOption *opt)
+{
+    rd->hIni    = hIni;
+    rd->sect    = NULL;
+    rd->line    = rd->buffer;
+    rd->szLine  = FI_BUFFER_SIZE;
+    rd->lenLine = 0;
+    rd->cr      = 0;
+    rd->opt     = opt;
+    rd->lineNo  = 0;
+    rd->seen    = NULL;
+
+    rd->error     = 0;
+    rd->bom       = 0;
+    rd->offset    = 0;
+    rd->lineStart = 0;
+    rd->seqStart  = 0;
+    rd->need      = 0;
+    rd->lo        = 0x80;
+    rd->hi        = 0xBF;
+
+    rd->events   = NULL;
+    rd->ctx      = NULL;
+    rd->sectName = NULL;
+    rd->szSect   = 0;
+    rd->lenSect  = 0;
+
+    if (opt) {
+        opt->violations = 0;
+        opt->error      = 0;
+        opt->offset     = 0;
+
+        if ( hIni && (opt->flags & FI_OPT_NOCASE) ) {
+            hIni->flags = hIni->flags | FI_OPT_NOCASE;
+        }
+
+        if ( hIni && (opt->flags & FI_OPT_TREE) ) {
+            fiTreeBuild(hIni, opt->separator);
+        }
+
+        if (opt->schema) {
+            rd->seen = (uint8_t *)calloc(opt->schema->count + 1, sizeof(uint8_t));
+            if (rd->seen == NULL) {
+                lErr("Allocate failed...");
+                rd->opt = NULL;
+            }
+        }
+    }
+}
+
+void fiReaderFree(stFIReader *rd)
+{
+    if (rd->line != rd->buffer) {
+        free(rd->line);
+    }
+
+    if (rd->seen) {
+        free(rd->seen);
+        rd->seen = NULL;
+    }
+
+    if (rd->sectName) {
+        free(rd->sectName);
+        rd->sectName = NULL;
+    }
+
+    rd->line   = rd->buffer;
+    rd->szLine = FI_BUFFER_SIZE;
+}
+
+int fiReaderFail(stFIReader *rd, int error, size_t offset)
+{
+    if (rd->error == 0) {
+        rd->error = error;
+        if (rd->opt) {
+            rd->opt->error  = error;
+            rd->opt->offset = offset;
+        }
+    }
+
+    return rd->error;
+}
+
+/* Charges an allocation to opt->maxHeap before it is made */
+int fiReaderCharge(stFIReader *rd, size_t size)
+{
+    if ( rd->opt && rd->opt->maxHeap ) {
+        rd->heap = rd->heap + size;
+        if (rd->heap > rd->opt->maxHeap) {
+            return fiReaderFail(rd, -EDQUOT, rd->lineStart);
+        }
+    }
+
+    return 0;
+}
+
+/* Checks opt->maxSections, opt->maxKeys and opt->maxHeap before a line is added to the tree */
+int fiReaderLimit(stFIReader *rd, const stFIEvent *ev)
+{
+    const stFIOption *opt = rd->opt;
+
+    size_t size = sizeof(stFINode);
+
+    if (opt == NULL) {
+        return 0;
+    }
+
+    switch(ev->type) {
+    case E_INI_T_SECTION  :
+        if ( opt->maxSections && (rd->hIni->count >= opt->maxSections)
+          && (fiFindSection(rd->hIni, ev->sect.str) == NULL) ) {
+            return fiReaderFail(rd, -ENOSPC, rd->lineStart);
+        }
+        size = size + sizeof(stFISection) + sizeof(stFIHandle) + ev->sect.len + 1 + (sizeof(stFINode *) << 1);
+        break;
+
+    case E_INI_T_PROPERTY :
+        // The global section is made by the first property before any section header
+        if ( opt->maxSections && (rd->sect == NULL) && (rd->hIni->count >= opt->maxSections)
+          && (fiFindSection(rd->hIni, "") == NULL) ) {
+            return fiReaderFail(rd, -ENOSPC, rd->lineStart);
+        }
+        // Property nodes of the section : E_INI_D_FIRST keeps a node per duplicate line,
+        // E_INI_D_LAST and E_INI_D_LIST fold a known key into its node and add none
+        if ( opt->maxKeys && rd->sect && (rd->sect->hIni->count >= opt->maxKeys)
+          && ( (opt->duplicate == E_INI_D_FIRST) || (fiFindProperty(rd->sect->hIni, ev->key.str) == NULL) ) ) {
+            return fiReaderFail(rd, -EMLINK, rd->lineStart);
+        }
+        size = size + sizeof(stFIProperty) + ev->key.len + 1 + ev->val.len + 1 + (sizeof(stFINode *) << 1);
+        break;
+
+    case E_INI_T_COMMENT  : size = size + ev->val.len + 1; break;
+    default               : break;
+    }
+
+    return fiReaderCharge(rd, size);
+}
+
+/* Escapes FI_LIST_SEPARATOR and FI_LIST_ESCAPE of src into dst, or only sizes it when dst is NULL */
+size_t fiListEscape(char *dst, const char *src, size_t len)
+{
+    size_t idx    = 0,
+           length = 0;
+
+    for (idx = 0; idx < len; idx++) {
+        if ( (src[idx] == FI_LIST_SEPARATOR) || (src[idx] == FI_LIST_ESCAPE) ) {
+            if (dst) { dst[length] = FI_LIST_ESCAPE; }
+            length = length + 1;
+        }
+        if (dst) { dst[length] = src[idx]; }
+        length = length + 1;
+    }
+
+    return length;
+}
+
+/* Appends the escaped value to *val, with a FI_LIST_SEPARATOR when *val already has one */
+int fiListAppend(char **val, size_t *lenVal, const char *src, size_t len)
+{
+    size_t sep    = (*val) ? 1 : 0,
+           length = fiListEscape(NULL, src, len);
+
+    char *ptr = NULL;
+
+    ptr = (char *)realloc(*val, *lenVal + sep + length + 1);
+    if (ptr == NULL) {
+        lErr("Allocate failed...");
+        return -ENOMEM;
+    }
+
+    if (sep) { ptr[*lenVal] = FI_LIST_SEPARATOR; }
+    fiListEscape(&ptr[*lenVal + sep], src, len);
+    ptr[*lenVal + sep + length] = '\0';
+
+    *val    = ptr;
+    *lenVal = *lenVal + sep + length;
+
+    return 0;
+}
+
+/* Property line under E_INI_D_LAST or E_INI_D_LIST, folded into an earlier one of the same key */
+int fiReaderDuplicate(stFIReader *rd, const char *key, char *value, stFIProperty **prop)
+{
+    int ret = 0;
+
+    char   *val    = NULL;
+    size_t  lenVal = 0;
+
+    stFIProperty *item = NULL,
+                 *prev = NULL;
+
+    prev = fiFindProperty(rd->sect->hIni, key);
+    if (prev == NULL) {
+        return fiInsertProperty(rd->sect, key, value, prop);
+    }
+
+    item = (stFIProperty *)fiMakeProperty(key, value);
+    if (item == NULL) {
+        lWrn("fiMakeProperty() failed!!!");
+        return -EFAULT;
+    }
+
+    if (rd->opt->duplicate == E_INI_D_LAST) {
+        val          = prev->val;
+        prev->val    = item->val;
+        prev->lenVal = item->lenVal;
+        item->val    = val;
+    }
+    else {
+        // Every line is one item : a value not joined yet(version 0) is escaped on its first duplicate
+        if ( (prev->version == 0) && (prev->val != NULL) ) {
+            ret = fiListAppend(&val, &lenVal, prev->val, prev->lenVal);
+            if (ret == 0) {
+                free(prev->val);
+                prev->val    = val;
+                prev->lenVal = lenVal;
+            }
+        }
+        if ( (ret == 0) && (item->val != NULL) ) {
+            ret = fiListAppend(&prev->val, &prev->lenVal, item->val, item->lenVal);
+        }
+    }
+
+    prev->version = prev->version + 1;
+    prev->type    = E_INI_V_STRING;
+    *prop         = prev;
+
+    fiDestroyValue(E_INI_T_PROPERTY, item);
+
+    return ret;
+}
+
+/* fiParseStream() consumer, a non zero callback result stops the parse */
+int fiReaderEvent(stFIReader *rd, stFIEvent *ev)
+{
+    int ret = 0;
+
+    char *name = NULL;
+
+    int (*event)(void *ctx, const stFIEvent *ev) = NULL;
+
+    switch(ev->type) {
+    case E_INI_T_SECTION  :
+        if (ev->sect.len + 1 > rd->szSect) {
+            name = (char *)realloc(rd->sectName, ev->sect.len + 1);
+            if (name == NULL) {
+                lErr("Allocate failed...");
+                return fiReaderFail(rd, -ENOMEM, rd->offset);
+            }
+            rd->sectName = name;
+            rd->szSect   = ev->sect.len + 1;
+        }
+        memcpy(rd->sectName, ev->sect.str, ev->sect.len + 1);
+        rd->lenSect = ev->sect.len;
+
+        event = rd->events->section;
+        break;
+
+    case E_INI_T_PROPERTY : event = rd->events->property; break;
+    case E_INI_T_COMMENT  : event = rd->events->comment;  break;
+    case E_INI_T_BLANK    : event = rd->events->blank;    break;
+    default               : break;
+    }
+
+    ev->sect.str = (rd->sectName) ? rd->sectName : "";
+    ev->sect.len = rd->lenSect;
+
+    if (event) {
+        ret = event(rd->ctx, ev);
+        if (ret != 0) {
+            fiReaderFail(rd, ret, rd->lineStart);
+        }
+    }
+
+    return ret;
+}
+
+int fiReaderLine(stFIReader *rd, char *line, size_t size)
+{
+    int ret = 0;
+
+    stFIEvent     ev;
+    stFIProperty *prop = NULL;
+
+    rd->lineNo = rd->lineNo + 1;
+
+    fiTokenize(line, size, &ev);
+    if (rd->events) {
+        ev.line = rd->lineNo;
+        return fiReaderEvent(rd, &ev);
+    }
+
+    if (fiReaderLimit(rd, &ev) != 0) {
+        return rd->error;
+    }
+
+    // Tree consumer
+    switch(ev.type) {
+    case E_INI_T_BLANK    :
+        ret = fiInsert(rd->hIni, E_INI_T_BLANK, NULL, 0);
+        break;
+
+    case E_INI_T_SECTION  :
+        ret = fiInsertSection(rd->hIni, ev.sect.str, &rd->sect);
+        if ( (ret == 0) && rd->sect && rd->hIni->tree ) {
+            fiTreeAdd(rd->hIni->tree, rd->sect);
+        }
+        if ( (ret == 0) && rd->seen && rd->sect
+          && (rd->opt->schema->flags & FI_SCHEMA_STRICT)
+          && (fiSchemaFind(rd->opt->schema, (rd->sect->name) ? rd->sect->name : "", rd->sect->lenName, NULL, 0) < 0) ) {
+            fiSchemaReport(rd, rd->lineNo, -EPERM, rd->sect->name, NULL, NULL);
+        }
+        break;
+
+    case E_INI_T_PROPERTY :
+        if (rd->sect == NULL) {
+            rd->sect = fiSearchSection(rd->hIni, "");
+            if (rd->sect == NULL) {
+                lWrn("fiSearchSection() failed!!!");
+                ret = -EFAULT;
+                break;
+            }
+
+            if ( rd->seen && (rd->opt->schema->flags & FI_SCHEMA_STRICT)
+              && (fiSchemaFind(rd->opt->schema, "", 0, NULL, 0) < 0) ) {
+                fiSchemaReport(rd, rd->lineNo, -EPERM, "", NULL, NULL);
+            }
+        }
+
+        if ( rd->opt && (rd->opt->duplicate != E_INI_D_FIRST) ) {
+            ret = fiReaderDuplicate(rd, ev.key.str, (ev.val.len > 0) ? (char *)ev.val.str : NULL, &prop);
+        }
+        else {
+            ret = fiInsertProperty(rd->sect, ev.key.str, (ev.val.len > 0) ? (char *)ev.val.str : NULL, &prop);
+        }
+
+        if ( (ret == 0) && rd->seen ) {
+            fiSchemaCheck(rd, rd->sect, prop, rd->lineNo);
+        }
+        break;
+
+    case E_INI_T_COMMENT  : ret = fiInsertComment(rd->hIni, ev.val.str, ev.val.len); break;
+    case E_INI_T_UNKNOWN  :
+    default               : break;
+    }
+
+    return ret;
+}
+
+int fiReaderAppend(stFIReader *rd, const char *str, size_t size)
+{
+    int ret = 0;
+
+    size_t length = 0;
+
+    char *line = NULL;
+
+    if ( rd->opt && rd->opt->maxLine && (rd->lenLine + size > rd->opt->maxLine) ) {
+        return fiReaderFail(rd, -EMSGSIZE, rd->lineStart);
+    }
+
+    if (rd->lenLine + size + 1 > rd->szLine) {
+        length = rd->szLine;
+        while (rd->lenLine + size + 1 > length) {
+            length = length << 1;
+        }
+
+        if (fiReaderCharge(rd, length - rd->szLine) != 0) {
+            return rd->error;
+        }
+
+        line = (char *)malloc(length);
+        if (line == NULL) {
+            lErr("Allocate failed...");
+            ret = -ENOMEM;
+        }
+        else {
+            memcpy(line, rd->line, rd->lenLine);
+            if (rd->line != rd->buffer) {
+                free(rd->line);
+            }
+
+            rd->line   = line;
+            rd->szLine = length;
+        }
+    }
+
+    if (ret == 0) {
+        memcpy(&rd->line[rd->lenLine], str, size);
+        rd->lenLine = rd->lenLine + size;
+    }
+
+    return ret;
+}
+
+/* Splits a chunk into lines(CR, LF or CRLF), lines may span chunk borders */
+int fiReaderSplit(stFIReader *rd, const char *ptr, size_t size)
+{
+    int ret = 0;
+
+    size_t offset = 0,
+           offEnd = 0,
+           base   = rd->offset - size; // rd->offset is already past the chunk
+
+    if ( rd->cr && (size > 0) && (ptr[0] == 0x0A) ) {
+        offset = 1;
+    }
+    rd->cr = 0;
+
+    while ( (ret == 0) && (rd->error == 0) && (offset < size) ) {
+        if (rd->lenLine == 0) {
+            rd->lineStart = base + offset;
+        }
+
+        offEnd = offset;
+        while ( (offEnd < size) && (ptr[offEnd] != 0x0D) && (ptr[offEnd] != 0x0A) ) {
+            offEnd = offEnd + 1;
+        }
+
+        if (offEnd > offset) {
+            ret = fiReaderAppend(rd, &ptr[offset], offEnd - offset);
+        }
+
+        if ( (ret == 0) && (offEnd < size) ) {
+            // A malformed line is skipped, it does not stop the parse
+            rd->line[rd->lenLine] = 0x00;
+            fiReaderLine(rd, rd->line, rd->lenLine);
+            rd->lenLine = 0;
+
+            if (ptr[offEnd] == 0x0D) {
+                if      (offEnd + 1 == size)       { rd->cr = 1; }
+                else if (ptr[offEnd + 1] == 0x0A)  { offEnd = offEnd + 1; }
+            }
+            offEnd = offEnd + 1;
+        }
+
+        offset = offEnd;
+    }
+
+    return (ret == 0) ? rd->error : ret;
+}
+
+/**
+ * UTF-8 check, the sequence state carries across chunks. Only ASCII has a fast path :
+ * runs are skipped 64/16 bytes at a time with SSE2(8 with a word otherwise). Multibyte
+ * text goes through the byte at a time state machine, it is not validated at memory bandwidth.
+ */
+int fiReaderUtf8(stFIReader *rd, const uint8_t *ptr, size_t size)
+{
+    size_t idx = 0;
+
+    uint8_t ch = 0;
+
+    while (idx < size) {
+        if (rd->need == 0) {
+#if defined(__SSE2__)
+            while ( (idx + 64 <= size)
+              && (_mm_movemask_epi8(_mm_or_si128(
+                      _mm_or_si128(_mm_loadu_si128((const __m128i *)&ptr[idx]),      _mm_loadu_si128((const __m128i *)&ptr[idx + 16])),
+                      _mm_or_si128(_mm_loadu_si128((const __m128i *)&ptr[idx + 32]), _mm_loadu_si128((const __m128i *)&ptr[idx + 48])))) == 0) ) {
+                idx = idx + 64;
+            }
+
+            while ( (idx + 16 <= size) && (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)&ptr[idx])) == 0) ) {
+                idx = idx + 16;
+            }
+#else
+            uint64_t word = 0;
+
+            while (idx + 8 <= size) {
+                memcpy(&word, &ptr[idx], sizeof(uint64_t));
+                if (word & 0x8080808080808080ULL) {
+                    break;
+                }
+                idx = idx + 8;
+            }
+#endif
+            while ( (idx < size) && (ptr[idx] < 0x80) ) {
+                idx = idx + 1;
+            }
+
+            if (idx == size) {
+                break;
+            }
+
+            ch          = ptr[idx];
+            rd->seqStart = rd->offset + idx;
+            rd->lo       = 0x80;
+            rd->hi       = 0xBF;
+
+            if      ( (ch >= 0xC2) && (ch <= 0xDF) ) { rd->need = 1; }
+            else if (ch == 0xE0)                     { rd->need = 2; rd->lo = 0xA0; } // overlong
+            else if (ch == 0xED)                     { rd->need = 2; rd->hi = 0x9F; } // surrogates
+            else if ( (ch >= 0xE1) && (ch <= 0xEF) ) { rd->need = 2; }
+            else if (ch == 0xF0)                     { rd->need = 3; rd->lo = 0x90; } // overlong
+            else if (ch == 0xF4)                     { rd->need = 3; rd->hi = 0x8F; } // above U+10FFFF
+            else if ( (ch >= 0xF1) && (ch <= 0xF3) ) { rd->need = 3; }
+            else {
+                return fiReaderFail(rd, -EILSEQ, rd->seqStart);
+            }
+        }
+        else {
+            ch = ptr[idx];
+            if ( (ch < rd->lo) || (ch > rd->hi) ) {
+                return fiReaderFail(rd, -EILSEQ, rd->seqStart);
+            }
+
+            rd->need = rd->need - 1;
+            rd->lo   = 0x80;
+            rd->hi   = 0xBF;
+        }
+
+        idx = idx + 1;
+    }
+
+    return 0;
+}
+
+int fiReaderData(stFIReader *rd, const char *ptr, size_t size)
+{
+    int ret = 0;
+
+    if ( rd->opt && rd->opt->maxBytes && (rd->offset + size > rd->opt->maxBytes) ) {
+        return fiReaderFail(rd, -EFBIG, rd->opt->maxBytes);
+    }
+
+    if ( rd->opt && (rd->opt->flags & FI_OPT_UTF8) ) {
+        ret = fiReaderUtf8(rd, (const uint8_t *)ptr, size);
+    }
+
+    if (ret == 0) {
+        rd->offset = rd->offset + size;
+        ret = fiReaderSplit(rd, ptr, size);
+        if (ret != 0) {
+            ret = fiReaderFail(rd, ret, rd->offset);
+        }
+    }
+
+    return ret;
+}
+
+int fiReaderFeed(stFIReader *rd, const char *ptr, size_t size)
+{
+    static const char bom[3] = { (char)0xEF, (char)0xBB, (char)0xBF };
+
+    int ret = rd->error,
+        len = 0;
+
+    // A BOM may be split across chunks, bytes that turn out not to be one are fed back
+    while ( (ret == 0) && (rd->bom >= 0) && (size > 0) ) {
+        if (ptr[0] == bom[rd->bom]) {
+            rd->bom = rd->bom + 1;
+            ptr     = ptr + 1;
+            size    = size - 1;
+
+            if (rd->bom == 3) {
+                rd->bom    = -1;
+                rd->offset = 3;
+                if ( rd->opt && (rd->opt->flags & FI_OPT_BOM_REJECT) ) {
+                    ret = fiReaderFail(rd, -EBADMSG, 0);
+                }
+            }
+        }
+        else {
+            len     = rd->bom;
+            rd->bom = -1;
+            if (len > 0) {
+                ret = fiReaderData(rd, bom, len);
+            }
+        }
+    }
+
+    if ( (ret == 0) && (size > 0) ) {
+        ret = fiReaderData(rd, ptr, size);
+    }
+
+    return ret;
+}
+
+int fiReaderFinish(stFIReader *rd)
+{
+    int ret = 0;
+
+    if ( (rd->error == 0) && (rd->bom > 0) ) {
+        ret     = rd->bom;
+        rd->bom = -1;
+        fiReaderData(rd, "\xEF\xBB", (size_t)ret);
+    }
+
+    if ( (rd->error == 0) && (rd->need > 0) ) {
+        fiReaderFail(rd, -EILSEQ, rd->seqStart);
+    }
+
+    if ( (rd->error == 0) && (rd->lenLine > 0) ) {
+        rd->line[rd->lenLine] = 0x00;
+        fiReaderLine(rd, rd->line, rd->lenLine);
+        rd->lenLine = 0;
+    }
+
+    if ( (rd->error == 0) && rd->seen ) {
+        fiSchemaFinish(rd);
+    }
+
+    ret = rd->error;
+
+    fiReaderFree(rd);
+
+    return ret;
+}
+
+/* Feeds fd to the reader until EOF, an error or a stop */
+int fiReaderRead(stFIReader *rd, int fd)
+{
+    int ret = 0;
+
+    ssize_t szRead = 0;
+
+	char ptr[FI_BUFFER_SIZE] = {0,};
+
+    do {
+        szRead = read(fd, ptr, FI_BUFFER_SIZE);
+        if ( (szRead > 0) && ((ret = fiReaderFeed(rd, ptr, (size_t)szRead)) != 0) ) {
+            break;
+        }
+        else if ( (szRead == -1) && (errno != EINTR) ) {
+            // A short input must not pass as a complete one
+            lErr("read() failed...");
+            ret = fiReaderFail(rd, -EIO, rd->offset);
+            break;
+        }
+    } while ( (szRead > 0) || ((szRead == -1) && (errno == EINTR)) );
+
+    return ret;
+}
+
+stFIHandle *fiProcReadOpt(int fd, stFIOption *opt)
+{
+    stFIReader  rd;
+    stFIHandle *hIni = NULL;
+
+	if (fd == -1) {
+        lWrn("Ini file descriptor invaild!!!");
+    }
+    else {
+        hIni = fiInit();
+        if (hIni) {
+            fiReaderInit(&rd, hIni, opt);
+            if (fiReaderRead(&rd, fd) != 0) {
+                fiReaderFail(&rd, -EIO, rd.offset);
+            }
+
+            if (fiReaderFinish(&rd) != 0) {
+                lWrn("Ini parse failed(%d)", rd.error);
+                fiDestroy(hIni);
+                hIni = NULL;
+            }
+        }
+    }
+
+    return hIni;
+}
+
+stFIHandle *fiProcRead(int fd)
+{
+    return fiProcReadOpt(fd, NULL);
+}
+
+stFIHandle *fiParseFd(int fd)
+{
+    return fiProcReadOpt(fd, NULL);
+}
+
+stFIHandle *fiParseFdOpt(int fd, stFIOption *opt)
+{
+    return fiProcReadOpt(fd, opt);
+}
+
+int fiParseStream(int fd, const char *buf, size_t size, const stFIEvents *events, void *ctx)
+{
+    int ret = 0;
+
+    stFIReader rd;
+
+    if (events == NULL) {
+        lWrn("Is Not exist events!!!");
+        ret = -EINVAL;
+    }
+    else if ( (fd == -1) && (buf == NULL) && (size > 0) ) {
+        lWrn("Ini buffer is not exist!!!");
+        ret = -EINVAL;
+    }
+    else {
+        fiReaderInit(&rd, NULL, NULL);
+        rd.events = events;
+        rd.ctx    = ctx;
+
+        if (fd != -1) {
+            ret = fiReaderRead(&rd, fd);
+        }
+        else {
+            fiReaderFeed(&rd, buf, size);
+        }
+
+        if (fiReaderFinish(&rd) != 0) {
+            ret = rd.error;
+        }
+    }
+
+    return ret;
+}
+
+stFIHandle *fiParseBuffer(const char *buf, size_t size)
+{
+    return fiParseBufferOpt(buf, size, NULL);
+}
+
+stFIHandle *fiParseBufferOpt(const char *buf, size_t size, stFIOption *opt)
+{
+    stFIReader  rd;
+    stFIHandle *hIni = NULL;
+
+    if ( (buf == NULL) && (size > 0) ) {
+        lWrn("Ini buffer is not exist!!!");
+    }
+    else {
+        hIni = fiInit();
+        if (hIni) {
+            fiReaderInit(&rd, hIni, opt);
+            fiReaderFeed(&rd, buf, size);
+            if (fiReaderFinish(&rd) != 0) {
+                lWrn("Ini parse failed(%d)", rd.error);
+                fiDestroy(hIni);
+                hIni = NULL;
+            }
+        }
+    }
+
+    return hIni;
+}
+
+int fiWriterFlush(stFIWriter *wr)
+{
+    size_t  offset = 0;
+    ssize_t szWrite = 0;
+
+    while ( (wr->error == 0) && (offset < wr->used) ) {
+        szWrite = write(wr->fd, &wr->ptr[offset], wr->used - offset);
+        if (szWrite > 0) {
+            offset = offset + (size_t)szWrite;
+        }
+        else if ( (szWrite == -1) && (errno == EINTR) ) {
+            continue;
+        }
+        else {
+            lErr("write() failed...");
+            wr->error = -EIO;
+        }
+    }
+
+    wr->used = 0;
+
+    return wr->error;
+}
+
+/* fd != -1 : buffered write, ptr != NULL : copy to memory, otherwise only counts */
+void fiWriterPut(stFIWriter *wr, const char *str, size_t size)
+{
+    size_t length = 0;
+
+    if (wr->fd != -1) {
+        while ( (wr->error == 0) && (size > 0) ) {
+            if (wr->used == wr->size) {
+                fiWriterFlush(wr);
+            }
+
+            length = wr->size - wr->used;
+            if (length > size) { length = size; }
+
+            memcpy(&wr->ptr[wr->used], str, length);
+            wr->used  = wr->used + length;
+            wr->total = wr->total + length;
+
+            str  = str + length;
+            size = size - length;
+        }
+    }
+    else {
+        if ( (wr->ptr != NULL) && (wr->total + size <= wr->size) ) {
+            memcpy(&wr->ptr[wr->total], str, size);
+        }
+        wr->total = wr->total + size;
+    }
+}
+
+/* Value that would not read back as written : blank ends, leading quote or comment mark, inline comment, line break */
+int fiValueQuote(const char *val, size_t size)
+{
+    size_t offset = 0;
+
+    if ( (size > 0)
+      && (FI_BLANK(val[0]) || FI_BLANK(val[size - 1]) || (val[0] == '"') || (val[0] == ';') || (val[0] == '#')) ) {
+        return 1;
+    }
+
+    for (offset = 0; offset < size; offset++) {
+        if ( (val[offset] == '\r') || (val[offset] == '\n')
+          || ( ((val[offset] == ';') || (val[offset] == '#')) && FI_BLANK(val[offset - 1]) ) ) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void fiWriterValue(stFIWriter *wr, const char *val, size_t size)
+{
+    size_t offset = 0,
+           offRun = 0;
+
+    const char *esc = NULL;
+
+    if (fiValueQuote(val, size) == 0) {
+        fiWriterPut(wr, val, size);
+    }
+    else {
+        fiWriterPut(wr, "\"", 1);
+        for (offset = 0; offset < size; offset++) {
+            switch(val[offset]) {
+            case '"'  : esc = "\\\""; break;
+            case '\\' : esc = "\\\\"; break;
+            case '\n' : esc = "\\n";  break;
+            case '\r' : esc = "\\r";  break;
+            case '\t' : esc = "\\t";  break;
+            default   : esc = NULL;  break;
+            }
+
+            if (esc) {
+                fiWriterPut(wr, &val[offRun], offset - offRun);
+                fiWriterPut(wr, esc, 2);
+                offRun = offset + 1;
+            }
+        }
+        fiWriterPut(wr, &val[offRun], size - offRun);
+        fiWriterPut(wr, "\"", 1);
+    }
+}
+
+void fiProcEmit(stFIWriter *wr, stFIHandle *hIni)
+{
+    stFINode     *head = NULL;
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL;
+
+    for (head = hIni->head; head != NULL; head = head->next) {
+        switch(head->cfg.type) {
+        case E_INI_T_SECTION  :
+            sect = (stFISection *)head->value;
+            if (sect->name) {
+                fiWriterPut(wr, "[", 1);
+                fiWriterPut(wr, sect->name, sect->lenName);
+                fiWriterPut(wr, "]" FI_LINE, 1 + strlen(FI_LINE));
+            }
+            fiProcEmit(wr, sect->hIni);
+            break;
+
+        case E_INI_T_PROPERTY :
+            prop = (stFIProperty *)head->value;
+            fiWriterPut(wr, prop->key, prop->lenKey);
+            fiWriterPut(wr, " = ", 3);
+            if (prop->val) {
+                fiWriterValue(wr, prop->val, prop->lenVal);
+            }
+            fiWriterPut(wr, FI_LINE, strlen(FI_LINE));
+            break;
+
+        case E_INI_T_COMMENT  :
+            fiWriterPut(wr, "; ", 2);
+            fiWriterPut(wr, (char *)head->value, strlen((char *)head->value));
+            fiWriterPut(wr, FI_LINE, strlen(FI_LINE));
+            break;
+
+        case E_INI_T_BLANK    : fiWriterPut(wr, FI_LINE, strlen(FI_LINE)); break;
+        case E_INI_T_UNKNOWN  :
+        default               : break;
+        }
+    }
+}
+
+int fiProcSave(int fd, stFIHandle *hIni)
+{
+    int ret = 0;
+
+	char ptr[FI_BUFFER_SIZE] = {0,};
+
+    stFIWriter wr = { fd, ptr, FI_BUFFER_SIZE, 0, 0, 0 };
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if (fd == -1) {
+        lWrn("Save file descriptor invaoild!!!");
+        ret = -EINVAL;
+    }
+    else {
+        fiProcEmit(&wr, hIni);
+        ret = fiWriterFlush(&wr);
+    }
+
+    return ret;
+}
+
+int fiSaveToFd(int fd, stFIHandle *hIni)
+{
+    return fiProcSave(fd, hIni);
+}
+
+char *fiSaveToBuffer(stFIHandle *hIni, size_t *size)
+{
+    char *ptr = NULL;
+
+    stFIWriter wr = { -1, NULL, 0, 0, 0, 0 };
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else {
+        // Sizing pass, then one exactly sized allocation(+ NUL)
+        fiProcEmit(&wr, hIni);
+
+        ptr = (char *)malloc(wr.total + 1);
+        if (ptr == NULL) {
+            lErr("Allocate failed...");
+        }
+        else {
+            wr.ptr   = ptr;
+            wr.size  = wr.total;
+            wr.total = 0;
+
+            fiProcEmit(&wr, hIni);
+            ptr[wr.total] = 0x00;
+
+            if (size) { *size = wr.total; }
+        }
+    }
+
+    return ptr;
+}
+
+int fiFileSave(const char *file, stFIHandle *hIni)
+{
+    int fd  = -1,
+        ret = 0;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else {
+        fd = open(file, O_RDWR | O_CREAT | O_TRUNC, (mode_t)00666);
+        if (fd == -1) {
+            lErr("%s open() failed...", file);
+            ret = -EFAULT;
+        }
+        else {
+		    if (lseek(fd, 0, SEEK_SET) == (off_t)-1) {
+                lErr("%s lseek( 0, SEEK_SET) failed...", file);
+            }
+
+            ret = fiProcSave(fd, hIni);
+
+            if (fsync(fd) == -1) {
+                lErr("%s fsync() failed...", file);
+                if (ret == 0) { ret = -EIO; }
+            }
+
+            if (close(fd) == -1) {
+                lErr("%s close() failed...", file);
+                if (ret == 0) { ret = -EIO; }
+            }
+        }
+    }
+
+    return ret;
+}
+
+/* Bytes of the valid UTF-8 sequence at ptr, 0 when it is not one */
+size_t fiUtf8Length(const uint8_t *ptr, size_t size)
+{
+    size_t length = 0,
+           idx    = 0;
+
+    uint8_t lo = 0x80,
+            hi = 0xBF;
+
+    if      ( (ptr[0] >= 0xC2) && (ptr[0] <= 0xDF) ) { length = 2; }
+    else if (ptr[0] == 0xE0)                         { length = 3; lo = 0xA0; } // overlong
+    else if (ptr[0] == 0xED)                         { length = 3; hi = 0x9F; } // surrogates
+    else if ( (ptr[0] >= 0xE1) && (ptr[0] <= 0xEF) ) { length = 3; }
+    else if (ptr[0] == 0xF0)                         { length = 4; lo = 0x90; } // overlong
+    else if (ptr[0] == 0xF4)                         { length = 4; hi = 0x8F; } // above U+10FFFF
+    else if ( (ptr[0] >= 0xF1) && (ptr[0] <= 0xF3) ) { length = 4; }
+
+    if (length > size) {
+        return 0;
+    }
+
+    for (idx = 1; idx < length; idx++) {
+        if ( (ptr[idx] < lo) || (ptr[idx] > hi) ) {
+            return 0;
+        }
+        lo = 0x80;
+        hi = 0xBF;
+    }
+
+    return length;
+}
+
+/* JSON string, control bytes escaped, valid UTF-8 as is and any other byte as U+FFFD */
+void fiWriterJson(stFIWriter *wr, const char *str, size_t size)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    size_t offset = 0,
+           offRun = 0,
+           length = 0;
+
+    uint8_t ch = 0;
+
+    char esc[6] = { '\\', 'u', '0', '0', '0', '0' };
+
+    fiWriterPut(wr, "\"", 1);
+    for (offset = 0; offset < size; offset++) {
+        ch = (uint8_t)str[offset];
+        if ( (ch >= 0x20) && (ch < 0x80) && (ch != '"') && (ch != '\\') ) {
+            continue;
+        }
+
+        if (ch >= 0x80) {
+            length = fiUtf8Length((const uint8_t *)&str[offset], size - offset);
+            if (length > 0) {
+                offset = offset + length - 1;
+                continue;
+            }
+
+            fiWriterPut(wr, &str[offRun], offset - offRun);
+            fiWriterPut(wr, "\\ufffd", 6);
+            offRun = offset + 1;
+            continue;
+        }
+
+        fiWriterPut(wr, &str[offRun], offset - offRun);
+        switch(ch) {
+        case '"'  : fiWriterPut(wr, "\\\"", 2); break;
+        case '\\' : fiWriterPut(wr, "\\\\", 2); break;
+        case '\n' : fiWriterPut(wr, "\\n", 2);  break;
+        case '\r' : fiWriterPut(wr, "\\r", 2);  break;
+        case '\t' : fiWriterPut(wr, "\\t", 2);  break;
+        default   :
+            esc[4] = hex[ch >> 4];
+            esc[5] = hex[ch & 0x0F];
+            fiWriterPut(wr, esc, 6);
+            break;
+        }
+        offRun = offset + 1;
+    }
+    fiWriterPut(wr, &str[offRun], size - offRun);
+    fiWriterPut(wr, "\"", 1);
+}
+
+/* Property line fiGet() returns, the later duplicates E_INI_D_FIRST keeps are hidden */
+int fiPropertyVisible(stFIHandle *hIni, stFINode *node)
+{
+    stFIProperty *prop = (stFIProperty *)node->value;
+
+    return fiFindNode(hIni, E_INI_T_PROPERTY, prop->key, prop->lenKey, prop->hash) == node;
+}
+
+/* "key":"value" pairs of a section, *first is cleared by the first one */
+void fiExportJsonKeys(stFIWriter *wr, stFIHandle *hIni, int *first)
+{
+    stFINode     *head = NULL;
+    stFIProperty *prop = NULL;
+
+    for (head = hIni->head; head != NULL; head = head->next) {
+        if ( (head->cfg.type == E_INI_T_PROPERTY) && fiPropertyVisible(hIni, head) ) {
+            prop = (stFIProperty *)head->value;
+            if (*first == 0) {
+                fiWriterPut(wr, ",", 1);
+            }
+            *first = 0;
+
+            fiWriterJson(wr, prop->key, prop->lenKey);
+            fiWriterPut(wr, ":", 1);
+            if (prop->val) {
+                fiWriterJson(wr, prop->val, prop->lenVal);
+            }
+            else {
+                fiWriterPut(wr, "null", 4);
+            }
+        }
+    }
+}
+
+void fiExportJsonEmit(stFIWriter *wr, stFIHandle *hIni)
+{
+    int first = 1,
+        inner = 1;
+
+    stFINode    *head = NULL;
+    stFISection *sect = NULL;
+
+    fiWriterPut(wr, "{", 1);
+    for (head = hIni->head; head != NULL; head = head->next) {
+        if (head->cfg.type == E_INI_T_SECTION) {
+            sect = (stFISection *)head->value;
+            if (sect->name == NULL) {
+                fiExportJsonKeys(wr, sect->hIni, &first);
+                continue;
+            }
+
+            if (first == 0) {
+                fiWriterPut(wr, ",", 1);
+            }
+            first = 0;
+            inner = 1;
+
+            fiWriterJson(wr, sect->name, sect->lenName);
+            fiWriterPut(wr, ":{", 2);
+            fiExportJsonKeys(wr, sect->hIni, &inner);
+            fiWriterPut(wr, "}", 1);
+        }
+    }
+    fiWriterPut(wr, "}\n", 2);
+}
+
+/* Environment name part, upper cased and bytes other than [A-Z0-9_] as '_' */
+void fiWriterEnvName(stFIWriter *wr, const char *str, size_t size)
+{
+    size_t offset = 0,
+           length = 0;
+
+    char ch = 0,
+         ptr[64];
+
+    for (offset = 0; offset < size; offset++) {
+        ch = str[offset];
+        if      ( (ch >= 'a') && (ch <= 'z') ) { ch = ch & ~0x20; }
+        else if ( ((ch < 'A') || (ch > 'Z')) && ((ch < '0') || (ch > '9')) ) { ch = '_'; }
+
+        ptr[length] = ch;
+        length      = length + 1;
+        if (length == sizeof(ptr)) {
+            fiWriterPut(wr, ptr, length);
+            length = 0;
+        }
+    }
+    fiWriterPut(wr, ptr, length);
+}
+
+/* Shell value, single quoted unless every byte is plain */
+void fiWriterEnvValue(stFIWriter *wr, const char *val, size_t size)
+{
+    size_t offset = 0,
+           offRun = 0;
+
+    while ( (offset < size)
+         && ( (((val[offset] | 0x20) >= 'a') && ((val[offset] | 0x20) <= 'z'))
+           || ((val[offset] >= '0') && (val[offset] <= '9'))
+           || ((val[offset] != 0x00) && (strchr("_-.,/:@%+=", val[offset]) != NULL)) ) ) {
+        offset = offset + 1;
+    }
+
+    if (offset == size) {
+        fiWriterPut(wr, val, size);
+        return;
+    }
+
+    fiWriterPut(wr, "'", 1);
+    for (offset = 0; offset < size; offset++) {
+        if (val[offset] == '\'') {
+            fiWriterPut(wr, &val[offRun], offset - offRun);
+            fiWriterPut(wr, "'\\''", 4);
+            offRun = offset + 1;
+        }
+    }
+    fiWriterPut(wr, &val[offRun], size - offRun);
+    fiWriterPut(wr, "'", 1);
+}
+
+void fiExportEnvEmit(stFIWriter *wr, stFIHandle *hIni)
+{
+    stFINode     *head = NULL,
+                 *item = NULL;
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL;
+
+    const char *name = NULL;
+
+    for (head = hIni->head; head != NULL; head = head->next) {
+        if (head->cfg.type != E_INI_T_SECTION) {
+            continue;
+        }
+
+        sect = (stFISection *)head->value;
+        for (item = sect->hIni->head; item != NULL; item = item->next) {
+            if ( (item->cfg.type != E_INI_T_PROPERTY) || (fiPropertyVisible(sect->hIni, item) == 0) ) {
+                continue;
+            }
+
+            prop = (stFIProperty *)item->value;
+
+            // A name may not start with a digit
+            name = (sect->name) ? sect->name : prop->key;
+            if ( (name[0] >= '0') && (name[0] <= '9') ) {
+                fiWriterPut(wr, "_", 1);
+            }
+
+            if (sect->name) {
+                fiWriterEnvName(wr, sect->name, sect->lenName);
+                fiWriterPut(wr, "_", 1);
+            }
+            fiWriterEnvName(wr, prop->key, prop->lenKey);
+            fiWriterPut(wr, "=", 1);
+            if (prop->val) {
+                fiWriterEnvValue(wr, prop->val, prop->lenVal);
+            }
+            fiWriterPut(wr, "\n", 1);
+        }
+    }
+}
+
+void fiExportFlatEmit(stFIWriter *wr, stFIHandle *hIni)
+{
+    static const char separator = FI_TREE_SEPARATOR;
+
+    stFINode     *head = NULL,
+                 *item = NULL;
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL;
+
+    for (head = hIni->head; head != NULL; head = head->next) {
+        if (head->cfg.type != E_INI_T_SECTION) {
+            continue;
+        }
+
+        sect = (stFISection *)head->value;
+        for (item = sect->hIni->head; item != NULL; item = item->next) {
+            if ( (item->cfg.type != E_INI_T_PROPERTY) || (fiPropertyVisible(sect->hIni, item) == 0) ) {
+                continue;
+            }
+
+            prop = (stFIProperty *)item->value;
+            if (sect->name) {
+                fiWriterPut(wr, sect->name, sect->lenName);
+                fiWriterPut(wr, &separator, 1);
+            }
+            fiWriterPut(wr, prop->key, prop->lenKey);
+            fiWriterPut(wr, "=", 1);
+            if (prop->val) {
+                fiWriterValue(wr, prop->val, prop->lenVal);
+            }
+            fiWriterPut(wr, "\n", 1);
+        }
+    }
+}
+
+int fiProcExport(int fd, stFIHandle *hIni, void (*emit)(stFIWriter *wr, stFIHandle *hIni))
+{
+    int ret = 0;
+
+    stFIWriter wr = { fd, NULL, FI_EXPORT_BUFFER, 0, 0, 0 };
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if (fd == -1) {
+        lWrn("Export file descriptor invalid!!!");
+        ret = -EINVAL;
+    }
+    else {
+        wr.ptr = (char *)malloc(FI_EXPORT_BUFFER);
+        if (wr.ptr == NULL) {
+            lErr("Allocate failed...");
+            ret = -ENOMEM;
+        }
+        else {
+            emit(&wr, hIni);
+            ret = fiWriterFlush(&wr);
+            free(wr.ptr);
+        }
+    }
+
+    return ret;
+}
+
+int fiExportJson(int fd, stFIHandle *hIni)
+{
+    return fiProcExport(fd, hIni, fiExportJsonEmit);
+}
+
+int fiExportEnv(int fd, stFIHandle *hIni)
+{
+    return fiProcExport(fd, hIni, fiExportEnvEmit);
+}
+
+int fiExportFlat(int fd, stFIHandle *hIni)
+{
+    return fiProcExport(fd, hIni, fiExportFlatEmit);
+}
+
+/* 64-bit FNV-1a of the whole file, read with pread() so the offset is kept */
+uint64_t fiCacheHash(int fd)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    off_t   offset = 0;
+    ssize_t szRead = 0,
+            idx    = 0;
+
+    char ptr[FI_BUFFER_SIZE] = {0,};
+
+    while ( ((szRead = pread(fd, ptr, FI_BUFFER_SIZE, offset)) > 0)
+         || ((szRead == -1) && (errno == EINTR)) ) {
+        for (idx = 0; idx < szRead; idx++) {
+            hash = (hash ^ (uint8_t)ptr[idx]) * 0x100000001B3ULL;
+        }
+        offset = offset + ((szRead > 0) ? szRead : 0);
+    }
+
+    return hash;
+}
+
+stFICache *fiCacheFind(const struct stat *sb)
+{
+    stFICache *cache = NULL;
+
+    for (cache = fiCacheHead; cache != NULL; cache = cache->next) {
+        if ( (cache->dev == sb->st_dev) && (cache->ino == sb->st_ino) ) {
+            break;
+        }
+    }
+
+    return cache;
+}
+
+void fiIndexBuild(stFIHandle *hIni)
+{
+    stFINode *head = NULL;
+
+    fiHashEnsure(hIni);
+
+    for (head = hIni->head; head != NULL; head = head->next) {
+        if (head->cfg.type == E_INI_T_SECTION) {
+            fiIndexBuild(((stFISection *)head->value)->hIni);
+        }
+    }
+}
+
+stFIHandle *fiCacheRead(int fd)
+{
+    int hit = 0;
+
+    uint32_t flags = 0;
+    uint64_t hash  = 0,
+             mtime = 0;
+
+    struct stat sb;
+
+    stFICache  *cache = NULL;
+    stFIHandle *base  = NULL,
+               *hIni  = NULL;
+
+    if (fstat(fd, &sb) == -1) {
+        lErr("fstat() failed...");
+    }
+    else {
+        mtime = (uint64_t)sb.st_mtim.tv_sec * 1000000000ULL + (uint64_t)sb.st_mtim.tv_nsec;
+        flags = __atomic_load_n(&fiCacheFlags, __ATOMIC_RELAXED);
+        if (flags & FI_CACHE_HASH) {
+            hash = fiCacheHash(fd);
+        }
+
+        pthread_mutex_lock(&fiCacheLock);
+        cache = fiCacheFind(&sb);
+        if (cache) {
+            if (flags & FI_CACHE_HASH) {
+                hit = (cache->size == sb.st_size) && (cache->hash == hash);
+            }
+            else {
+                hit = (cache->size == sb.st_size) && (cache->mtime == mtime);
+            }
+        }
+
+        if (hit) {
+            cache->mtime = mtime;
+            hIni = fiClone(cache->hIni);
+            fiCacheCount.hits = fiCacheCount.hits + 1;
+        }
+        pthread_mutex_unlock(&fiCacheLock);
+
+        if (hit == 0) {
+            base = fiProcRead(fd);
+            if (base) {
+                // Clones share the sections, index them now rather than lazily from several threads
+                fiIndexBuild(base);
+            }
+
+            pthread_mutex_lock(&fiCacheLock);
+            fiCacheCount.misses = fiCacheCount.misses + 1;
+
+            if (base) {
+                // Another thread may have filled the entry meanwhile, the latest parse wins
+                cache = fiCacheFind(&sb);
+                if (cache == NULL) {
+                    cache = (stFICache *)malloc(sizeof(stFICache));
+                    if (cache == NULL) {
+                        lErr("Allocate failed...");
+                    }
+                    else {
+                        cache->hIni = NULL;
+                        cache->next = fiCacheHead;
+                        fiCacheHead = cache;
+                        fiCacheCount.entries = fiCacheCount.entries + 1;
+                    }
+                }
+
+                if (cache) {
+                    if (cache->hIni) { fiDestroy(cache->hIni); }
+
+                    cache->dev   = sb.st_dev;
+                    cache->ino   = sb.st_ino;
+                    cache->size  = sb.st_size;
+                    cache->mtime = mtime;
+                    cache->hash  = hash;
+                    cache->hIni  = base;
+
+                    hIni = fiClone(base);
+                }
+                else {
+                    hIni = base;
+                }
+            }
+            pthread_mutex_unlock(&fiCacheLock);
+        }
+    }
+
+    return hIni;
+}
+
+int fiCacheSetup(uint32_t flags)
+{
+    __atomic_store_n(&fiCacheFlags, flags, __ATOMIC_RELAXED);
+
+    if ( (flags & FI_CACHE_ENABLE) == 0 ) {
+        fiCacheFlush();
+    }
+
+    return 0;
+}
+
+void fiCacheFlush(void)
+{
+    stFICache *cache = NULL;
+
+    pthread_mutex_lock(&fiCacheLock);
+    while ( (cache = fiCacheHead) != NULL ) {
+        fiCacheHead = cache->next;
+
+        fiDestroy(cache->hIni);
+        free(cache);
+    }
+    fiCacheCount.entries = 0;
+    pthread_mutex_unlock(&fiCacheLock);
+}
+
+void fiCacheStat(stFICacheStat *stat)
+{
+    if (stat) {
+        pthread_mutex_lock(&fiCacheLock);
+        *stat = fiCacheCount;
+        pthread_mutex_unlock(&fiCacheLock);
+    }
+}
+
+stFIHandle *fiFileRead(const char *file)
+{
+    return fiFileReadOpt(file, NULL);
+}
+
+char *fiJournalPath(const char *file)
+{
+    size_t length = strlen(file) + sizeof(FI_JOURNAL_SUFFIX);
+
+    char *path = NULL;
+
+    path = (char *)malloc(length);
+    if (path == NULL) {
+        lErr("Allocate failed...");
+    }
+    else {
+        snprintf(path, length, "%s" FI_JOURNAL_SUFFIX, file);
+    }
+
+    return path;
+}
+
+/* Applies the records of the journal of file, stops at the first torn or invalid record */
+/**
+ * Reads the records of the journal fd and applies them to hIni(NULL only scans).
+ * A torn or corrupt tail ends the scan and is ignored, *valid is where it starts.
+ */
+int fiJournalScan(int fd, const char *path, stFIHandle *hIni, size_t *valid)
+{
+    int ret = 0;
+
+    size_t offset = 0,
+           length = 0,
+           idx    = 0;
+
+    ssize_t szRead = 0;
+
+    uint32_t check = 0;
+
+    char *ptr = NULL,
+         *str[3];
+
+    struct stat sb;
+
+    stFIJournalRecord record;
+
+    *valid = 0;
+
+    if (fstat(fd, &sb) == -1) {
+        ret = -errno;
+        lErr("%s fstat() failed...", path);
+    }
+    else if (sb.st_size > 0) {
+        ptr = (char *)malloc(sb.st_size);
+        if (ptr == NULL) {
+            lErr("Allocate failed...");
+            ret = -ENOMEM;
+        }
+
+        while ( (ret == 0) && (offset < (size_t)sb.st_size) ) {
+            szRead = read(fd, &ptr[offset], sb.st_size - offset);
+            if (szRead > 0)                               { offset = offset + szRead; }
+            else if ( (szRead == -1) && (errno == EINTR) ) { continue; }
+            else if (szRead == 0)                         { break; }
+            else {
+                lErr("%s read() failed...", path);
+                ret = -EIO;
+            }
+        }
+        length = offset;
+
+        for (offset = 0; (ret == 0) && (offset + sizeof(stFIJournalRecord) <= length); ) {
+            memcpy(&record, &ptr[offset], sizeof(stFIJournalRecord));
+            if ( (record.magic != FI_JOURNAL_MAGIC)
+              || ((uint64_t)record.lenSect + record.lenKey + record.lenVal > length - offset - sizeof(stFIJournalRecord)) ) {
+                break;
+            }
+
+            // Terminate the fields in place, each is followed by the next one
+            str[0] = &ptr[offset + sizeof(stFIJournalRecord)];
+            str[1] = str[0] + record.lenSect;
+            str[2] = str[1] + record.lenKey;
+
+            check = 0x811C9DC5;
+            check = (check ^ fiHash(str[0], record.lenSect)) * 0x01000193;
+            check = (check ^ fiHash(str[1], record.lenKey))  * 0x01000193;
+            check = (check ^ fiHash(str[2], record.lenVal))  * 0x01000193;
+            if (check != record.check) {
+                break;
+            }
+
+            if (hIni) {
+                for (idx = 0; idx < 3; idx++) {
+                    str[idx] = strndup(str[idx], (idx == 0) ? record.lenSect : (idx == 1) ? record.lenKey : record.lenVal);
+                }
+
+                if ( (str[0] == NULL) || (str[1] == NULL) || (str[2] == NULL) ) {
+                    lErr("Allocate failed...");
+                    ret = -ENOMEM;
+                }
+                else {
+                    ret = fiPut(hIni, str[0], str[1], str[2]);
+                }
+
+                for (idx = 0; idx < 3; idx++) {
+                    if (str[idx]) { free(str[idx]); }
+                }
+            }
+
+            if (ret == 0) {
+                offset = offset + sizeof(stFIJournalRecord) + record.lenSect + record.lenKey + record.lenVal;
+                *valid = offset;
+            }
+        }
+
+        if ( (ret == 0) && (*valid < length) ) {
+            lWrn("%s torn at %zu, %zu bytes ignored", path, *valid, length - *valid);
+        }
+
+        if (ptr) { free(ptr); }
+    }
+
+    return ret;
+}
+
+/* Read only : the journal belongs to its writer, a torn tail may be a record still being written */
+int fiJournalReplay(stFIHandle *hIni, const char *file)
+{
+    int ret = 0,
+        fd  = -1;
+
+    size_t valid = 0;
+
+    char *path = NULL;
+
+    path = fiJournalPath(file);
+    if (path == NULL) {
+        ret = -ENOMEM;
+    }
+    else if ( (fd = open(path, O_RDONLY | O_CLOEXEC)) == -1 ) {
+        ret = (errno == ENOENT) ? 0 : -errno;
+        if (ret != 0) {
+            lErr("%s open() failed...", path);
+        }
+    }
+    else {
+        while ( (flock(fd, LOCK_SH) == -1) && (errno == EINTR) );
+
+        ret = fiJournalScan(fd, path, hIni, &valid);
+
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+
+    if (path) { free(path); }
+
+    return ret;
+}
+
+stFIHandle *fiFileReadOpt(const char *file, stFIOption *opt)
+{
+    int fd  = -1,
+        ret = 0;
+
+    struct stat sb;
+
+    stFIHandle *hIni = NULL;
+
+    if (stat(file, &sb) == -1) {
+        lErr("stat(%s, ) failed...", file);
+    }
+    else {
+        if ( S_ISREG(sb.st_mode) && opt && opt->maxBytes && ((size_t)sb.st_size > opt->maxBytes) ) {
+            // Fails before reading, a file still growing is cut off by the reader
+            lWrn("%s exceeds %zu bytes", file, opt->maxBytes);
+            opt->error  = -EFBIG;
+            opt->offset = opt->maxBytes;
+        }
+        else if ( S_ISREG(sb.st_mode) ) {
+            fd = open(file, O_RDONLY, (mode_t)00666);
+            if (fd == -1) {
+                lErr("%s open failed...", file);
+            }
+            else {
+                if ( (opt == NULL) && (__atomic_load_n(&fiCacheFlags, __ATOMIC_RELAXED) & FI_CACHE_ENABLE) ) {
+                    hIni = fiCacheRead(fd);
+                }
+                else {
+                    hIni = fiProcReadOpt(fd, opt);
+                }
+                close(fd);
+
+                // Without its journal the handle would miss committed updates
+                if ( hIni && ((ret = fiJournalReplay(hIni, file)) != 0) ) {
+                    lWrn("%s" FI_JOURNAL_SUFFIX " replay failed(%d)", file, ret);
+                    fiDestroy(hIni);
+                    hIni = NULL;
+                    if (opt) {
+                        opt->error  = ret;
+                        opt->offset = 0;
+                    }
+                }
+            }
+        }
+        else {
+            lWrn("%s is not file Regular file", file);
+        }
+    }
+
+    return hIni;
+}
+
+char *fiGetPropertyData(stFIHandle *hIni, const char *key)
+{
+    char     *value = NULL;
+
+    stFIProperty *prop = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else {
+        prop = fiFindProperty(hIni, key);
+        if (prop) {
+            value = (char *)prop->val;
+        }
+    }
+
+    return value;
+}
+
+char *fiGet(stFIHandle *hIni, const char *sect, const char *key)
+{
+    char *value = NULL;
+
+    stFISection *fiSect = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else {
+        fiSect = (stFISection *)fiFindSection(hIni, sect);
+        if (fiSect) {
+            value = (char *)fiGetPropertyData(fiSect->hIni, key);
+        }
+    }
+
+    return value;
+}
+
+stFIProperty *fiGetProperty(stFIHandle *hIni, const char *sect, const char *key)
+{
+    stFISection *fiSect = NULL;
+
+    fiSect = fiFindSection(hIni, sect);
+
+    return (fiSect) ? fiFindProperty(fiSect->hIni, key) : NULL;
+}
+
+stFIProperty *fiLookup(stFIHandle *hIni, const char *sect, size_t lenSect, uint32_t hashSect,
+                       const char *key, size_t lenKey, uint32_t hashKey)
+{
+    stFINode *node = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else if ( (sect != NULL) && (key != NULL) ) {
+        node = fiFindNode(hIni, E_INI_T_SECTION, sect, lenSect, hashSect);
+        if (node) {
+            node = fiFindNode(((stFISection *)node->value)->hIni, E_INI_T_PROPERTY, key, lenKey, hashKey);
+        }
+    }
+
+    return (node) ? (stFIProperty *)node->value : NULL;
+}
+
+int fiGetTyped(stFIHandle *hIni, const char *sect, const char *key, int type, int64_t *num, double *real)
+{
+    int ret = 0;
+
+    stFIProperty *prop = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if ( (prop = fiGetProperty(hIni, sect, key)) == NULL ) {
+        ret = -ENOENT;
+    }
+    else if (prop->type == type) {
+        *num  = prop->typed.num;
+        *real = prop->typed.real;
+    }
+    else {
+        ret = fiValueParse(type, prop->val, num, real);
+    }
+
+    return ret;
+}
+
+int fiGetInt(stFIHandle *hIni, const char *sect, const char *key, int64_t *value)
+{
+    double real = 0.0;
+
+    return fiGetTyped(hIni, sect, key, E_INI_V_INT, value, &real);
+}
+
+int fiGetDouble(stFIHandle *hIni, const char *sect, const char *key, double *value)
+{
+    int64_t num = 0;
+
+    return fiGetTyped(hIni, sect, key, E_INI_V_DOUBLE, &num, value);
+}
+
+int fiGetList(stFIHandle *hIni, const char *sect, const char *key, const stFISpan **list, size_t *count)
+{
+    int ret = 0;
+
+    size_t idx    = 0,
+           offset = 0,
+           length = 0,
+           escape = 0,
+           size   = 0;
+
+    const char *ptr  = NULL;
+    char       *text = NULL;
+
+    stFISection  *fiSect = NULL;
+    stFIProperty *prop   = NULL;
+    stFIList     *cache  = NULL;
+
+    if ( (hIni == NULL) || (list == NULL) || (count == NULL) ) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else if ( (prop = fiGetProperty(hIni, sect, key)) == NULL ) {
+        ret = -ENOENT;
+    }
+    else if ( (prop->list != NULL) && (prop->list->val == prop->val) && (prop->list->version == prop->version) ) {
+        *list  = prop->list->span;
+        *count = prop->list->count;
+    }
+    else if ( ((fiSect = fiOwnSectionOf(hIni, sect)) == NULL)
+           || ((prop = fiFindProperty(fiSect->hIni, key)) == NULL) ) {
+        lWrn("fiOwnSectionOf() failed!!!");
+        ret = -ENOMEM;
+    }
+    else {
+        length = (prop->val) ? 1 : 0;
+        for (offset = 0; offset < prop->lenVal; offset++) {
+            if (FI_LIST_ESCAPED(prop->val, prop->lenVal, offset)) {
+                escape = escape + 1;
+                offset = offset + 1;
+            }
+            else if (prop->val[offset] == FI_LIST_SEPARATOR) {
+                length = length + 1;
+            }
+        }
+
+        // Escaped items are copied behind the spans, the others point into the value
+        cache = (stFIList *)malloc(sizeof(stFIList) + length * sizeof(stFISpan) + ((escape) ? prop->lenVal : 0));
+        if (cache == NULL) {
+            lErr("Allocate failed...");
+            ret = -ENOMEM;
+        }
+        else {
+            cache->val     = prop->val;
+            cache->version = prop->version;
+            cache->count   = length;
+
+            text = (char *)&cache->span[length];
+            for (idx = 0, offset = 0; idx < length; idx++, offset++) {
+                ptr  = (escape) ? text : &prop->val[offset];
+                size = 0;
+                for (; (offset < prop->lenVal) && (prop->val[offset] != FI_LIST_SEPARATOR); offset++) {
+                    if (FI_LIST_ESCAPED(prop->val, prop->lenVal, offset)) {
+                        offset = offset + 1;
+                    }
+                    if (escape) { *text++ = prop->val[offset]; }
+                    size = size + 1;
+                }
+
+                cache->span[idx].str = ptr;
+                cache->span[idx].len = size;
+                while ( (cache->span[idx].len > 0) && FI_BLANK(cache->span[idx].str[0]) ) {
+                    cache->span[idx].str = cache->span[idx].str + 1;
+                    cache->span[idx].len = cache->span[idx].len - 1;
+                }
+                while ( (cache->span[idx].len > 0) && FI_BLANK(cache->span[idx].str[cache->span[idx].len - 1]) ) {
+                    cache->span[idx].len = cache->span[idx].len - 1;
+                }
+            }
+
+            if (prop->list) { free(prop->list); }
+            prop->list = cache;
+
+            *list  = cache->span;
+            *count = cache->count;
+        }
+    }
+
+    return ret;
+}
+
+int fiGetBool(stFIHandle *hIni, const char *sect, const char *key, int *value)
+{
+    int ret = 0;
+
+    int64_t num  = 0;
+    double  real = 0.0;
+
+    ret = fiGetTyped(hIni, sect, key, E_INI_V_BOOL, &num, &real);
+    if (ret == 0) {
+        *value = (int)num;
+    }
+
+    return ret;
+}
+
+void fiResolveAppend(stFIResolver *rs, const char *str, size_t size)
+{
+    size_t length = 0;
+
+    char *ptr = NULL;
+
+    if ( (rs->error == 0) && (rs->length + size + 1 > rs->size) ) {
+        length = (rs->size) ? rs->size : FI_RESOLVE_REF;
+        while (rs->length + size + 1 > length) {
+            length = length << 1;
+        }
+
+        ptr = (char *)realloc(rs->ptr, length);
+        if (ptr == NULL) {
+            lErr("Allocate failed...");
+            rs->error = -ENOMEM;
+        }
+        else {
+            rs->ptr  = ptr;
+            rs->size = length;
+        }
+    }
+
+    if (rs->error == 0) {
+        memcpy(&rs->ptr[rs->length], str, size);
+        rs->length = rs->length + size;
+    }
+}
+
+void fiResolveDepend(stFIResolver *rs, stFIProperty *prop)
+{
+    size_t length = 0;
+
+    stFIProperty **dep     = NULL;
+    uint32_t      *version = NULL;
+
+    if ( (rs->error == 0) && (rs->count == rs->szDep) ) {
+        length  = rs->szDep + FI_RESOLVE_DEPTH;
+        dep     = (stFIProperty **)realloc(rs->dep, length * sizeof(stFIProperty *));
+        if (dep) { rs->dep = dep; }
+
+        version = (uint32_t *)realloc(rs->version, length * sizeof(uint32_t));
+        if (version) { rs->version = version; }
+
+        if ( (dep == NULL) || (version == NULL) ) {
+            lErr("Allocate failed...");
+            rs->error = -ENOMEM;
+        }
+        else {
+            rs->szDep = length;
+        }
+    }
+
+    if (rs->error == 0) {
+        rs->dep[rs->count]     = prop;
+        rs->version[rs->count] = prop->version;
+        rs->count = rs->count + 1;
+    }
+}
+
+void fiResolveText(stFIResolver *rs, const char *sect, const char *str, size_t size)
+{
+    size_t offset = 0,
+           offEnd = 0,
+           idx    = 0;
+
+    char  ref[FI_RESOLVE_REF] = {0,};
+    char *key = NULL,
+         *env = NULL;
+
+    stFISection  *fiSect = NULL;
+    stFIProperty *fiProp = NULL;
+
+    while ( (rs->error == 0) && (offset < size) ) {
+        offEnd = offset;
+        while ( (offEnd < size) && (str[offEnd] != '$') ) {
+            offEnd = offEnd + 1;
+        }
+        fiResolveAppend(rs, &str[offset], offEnd - offset);
+        offset = offEnd;
+
+        if (offset + 1 >= size) {
+            fiResolveAppend(rs, &str[offset], size - offset);
+            break;
+        }
+        else if (str[offset + 1] == '$') {
+            fiResolveAppend(rs, "$", 1);
+            offset = offset + 2;
+            continue;
+        }
+        else if (str[offset + 1] != '{') {
+            fiResolveAppend(rs, "$", 1);
+            offset = offset + 1;
+            continue;
+        }
+
+        offEnd = offset + 2;
+        while ( (offEnd < size) && (str[offEnd] != '}') ) {
+            offEnd = offEnd + 1;
+        }
+
+        if ( (offEnd == size) || (offEnd - offset - 2 >= FI_RESOLVE_REF) ) {
+            // Not a reference, keep the text
+            fiResolveAppend(rs, "${", 2);
+            offset = offset + 2;
+            continue;
+        }
+
+        memcpy(ref, &str[offset + 2], offEnd - offset - 2);
+        ref[offEnd - offset - 2] = 0x00;
+        offset = offEnd + 1;
+
+        key = strchr(ref, ':');
+        if (key) { *key++ = 0x00; }
+        else     { key = ref; }
+
+        if ( (key != ref) && (strcmp(ref, "ENV") == 0) ) {
+            env = getenv(key);
+            if (env) {
+                fiResolveAppend(rs, env, strlen(env));
+            }
+            continue;
+        }
+
+        fiSect = fiFindSection(rs->hIni, (key != ref) ? ref : sect);
+        fiProp = (fiSect) ? fiFindProperty(fiSect->hIni, key) : NULL;
+        if (fiProp == NULL) {
+            continue;
+        }
+
+        for (idx = 0; idx < rs->depth; idx++) {
+            if (rs->stack[idx] == fiProp) {
+                lWrn("Reference cycle at %s:%s", (key != ref) ? ref : sect, key);
+                rs->error = -ELOOP;
+            }
+        }
+
+        if (rs->depth == FI_RESOLVE_DEPTH) {
+            lWrn("Reference too deep at %s:%s", (key != ref) ? ref : sect, key);
+            rs->error = -ELOOP;
+        }
+
+        fiResolveDepend(rs, fiProp);
+        if ( (rs->error == 0) && fiProp->val ) {
+            rs->stack[rs->depth++] = fiProp;
+            fiResolveText(rs, (fiSect->name) ? fiSect->name : "", fiProp->val, fiProp->lenVal);
+            rs->depth = rs->depth - 1;
+        }
+    }
+}
+
+int fiResolveValid(stFIHandle *hIni, stFIResolved *cache)
+{
+    int ret = 0;
+
+    size_t idx = 0;
+
+    if ( (cache != NULL) && (cache->epoch == hIni->epoch) ) {
+        ret = 1;
+        for (idx = 0; (idx < cache->count) && ret; idx++) {
+            ret = (cache->dep[idx]->version == cache->version[idx]);
+        }
+    }
+
+    return ret;
+}
+
+char *fiGetResolved(stFIHandle *hIni, const char *sect, const char *key)
+{
+    char *value = NULL;
+
+    size_t length = 0;
+
+    stFIResolver  rs;
+    stFIResolved *cache  = NULL;
+    stFISection  *fiSect = NULL;
+    stFIProperty *fiProp = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else {
+        fiSect = fiFindSection(hIni, sect);
+        fiProp = (fiSect) ? fiFindProperty(fiSect->hIni, key) : NULL;
+
+        if ( (fiProp == NULL) || (fiProp->val == NULL) ) {
+            value = NULL;
+        }
+        else if (memchr(fiProp->val, '$', fiProp->lenVal) == NULL) {
+            value = fiProp->val;
+        }
+        else if (fiResolveValid(hIni, fiProp->resolved)) {
+            value = fiProp->resolved->val;
+        }
+        else if ( ((fiSect = fiOwnSectionOf(hIni, sect)) == NULL)
+               || ((fiProp = fiFindProperty(fiSect->hIni, key)) == NULL) ) {
+            lWrn("fiOwnSectionOf() failed!!!");
+        }
+        else {
+            memset(&rs, 0, sizeof(stFIResolver));
+            rs.hIni     = hIni;
+            rs.stack[0] = fiProp;
+            rs.depth    = 1;
+
+            fiResolveDepend(&rs, fiProp);
+            fiResolveText(&rs, sect, fiProp->val, fiProp->lenVal);
+            fiResolveAppend(&rs, "", 0);
+
+            if (rs.error == 0) {
+                // One block : cache, dependency and version arrays, value
+                length = sizeof(stFIResolved)
+                       + rs.count * (sizeof(stFIProperty *) + sizeof(uint32_t))
+                       + rs.length + 1;
+
+                cache = (stFIResolved *)malloc(length);
+                if (cache == NULL) {
+                    lErr("Allocate failed...");
+                }
+                else {
+                    cache->epoch   = hIni->epoch;
+                    cache->count   = rs.count;
+                    cache->dep     = (stFIProperty **)&cache[1];
+                    cache->version = (uint32_t *)&cache->dep[rs.count];
+                    cache->val     = (char *)&cache->version[rs.count];
+                    cache->lenVal  = rs.length;
+
+                    memcpy(cache->dep, rs.dep, rs.count * sizeof(stFIProperty *));
+                    memcpy(cache->version, rs.version, rs.count * sizeof(uint32_t));
+                    memcpy(cache->val, rs.ptr, rs.length);
+                    cache->val[rs.length] = 0x00;
+
+                    if (fiProp->resolved) { free(fiProp->resolved); }
+                    fiProp->resolved = cache;
+
+                    value = cache->val;
+                }
+            }
+
+            if (rs.ptr)     { free(rs.ptr); }
+            if (rs.dep)     { free(rs.dep); }
+            if (rs.version) { free(rs.version); }
+        }
+    }
+
+    return value;
+}
+
+int fiJournalAppend(stFIJournal *journal, const char *sect, const char *key, const char *value)
+{
+    int ret = 0;
+
+    size_t  length  = 0;
+    ssize_t szWrite = 0;
+
+    uint32_t check = 0x811C9DC5;
+
+    stFIJournalRecord record;
+    struct iovec      iov[4];
+
+    record.magic   = FI_JOURNAL_MAGIC;
+    record.lenSect = (uint32_t)strlen(sect);
+    record.lenKey  = (uint32_t)strlen(key);
+    record.lenVal  = (uint32_t)strlen(value);
+
+    iov[1].iov_base = (void *)sect;  iov[1].iov_len = record.lenSect;
+    iov[2].iov_base = (void *)key;   iov[2].iov_len = record.lenKey;
+    iov[3].iov_base = (void *)value; iov[3].iov_len = record.lenVal;
+
+    // FNV-1a continued over the three fields
+    for (length = 1; length < 4; length++) {
+        check = (check ^ fiHash((const char *)iov[length].iov_base, iov[length].iov_len)) * 0x01000193;
+    }
+    record.check = check;
+
+    iov[0].iov_base = &record;
+    iov[0].iov_len  = sizeof(stFIJournalRecord);
+
+    length = sizeof(stFIJournalRecord) + record.lenSect + record.lenKey + record.lenVal;
+
+    // One O_APPEND write per record, readers take LOCK_SH and never see half of it
+    while ( (flock(journal->fd, LOCK_EX) == -1) && (errno == EINTR) );
+    do {
+        szWrite = writev(journal->fd, iov, 4);
+    } while ( (szWrite == -1) && (errno == EINTR) );
+    flock(journal->fd, LOCK_UN);
+
+    if ( (szWrite == -1) || ((size_t)szWrite != length) ) {
+        lErr("%s" FI_JOURNAL_SUFFIX " writev() failed...", journal->file);
+        ret = -EIO;
+    }
+    else if ( (journal->flags & FI_JOURNAL_SYNC) && (fdatasync(journal->fd) == -1) ) {
+        lErr("%s" FI_JOURNAL_SUFFIX " fdatasync() failed...", journal->file);
+        ret = -EIO;
+    }
+
+    return ret;
+}
+
+int fiPut(stFIHandle *hIni, const char *sect, const char *key, const char *value)
+{
+    int ret = 0;
+
+    size_t length = 0;
+
+    char *ptr = NULL;
+
+    stFINode *node = NULL;
+
+    stFISection  *fiSect = NULL;
+    stFIProperty *fiProp = NULL;
+
+    void *shared = NULL;
+
+    if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
+    }
+    else {
+        length = strlen(value) + 1;
+        node   = fiSearchSectionNode(hIni, sect);
+        shared = (node) ? node->value : NULL;
+        fiSect = (node) ? fiOwnSection(node) : NULL;
+        if (fiSect != shared) {
+            hIni->epoch = fiNextEpoch();
+        }
+
+        if (fiSect == NULL) {
+            // No section, or the copy of a shared one failed : nothing applied, nothing journaled
+            lWrn("Section(%s) is not writable!!!", sect);
+            ret = -ENOMEM;
+        }
+        else {
+            fiProp = fiFindProperty(fiSect->hIni, key);
+            if (fiProp == NULL) {
+                fiProp = (stFIProperty *)fiMakeProperty(key, (char *)value);
+                if (fiProp == NULL) {
+                    lWrn("fiMakeProperty() failed!!!");
+                    ret = -EFAULT;
+                }
+                else if (fiInsertValue(fiSect->hIni, E_INI_T_PROPERTY, fiProp) == NULL) {
+                    fiDestroyValue(E_INI_T_PROPERTY, fiProp);
+                    ret = -EFAULT;
+                }
+                else {
+                    hIni->epoch = fiNextEpoch();
+                }
+
+            }
+            else {
+                if (length > 1) {
+                    ptr = (char *)malloc(length);
+                    if (ptr == NULL) {
+                        lErr("Allocate failed...");
+                        ret = -EFAULT;
+                    }
+                    else {
+                        snprintf(ptr, length, "%s", value);
+                    }
+                }
+
+                if (ret == 0) {
+                    if (fiProp->val) { free(fiProp->val); }
+
+                    fiProp->val     = ptr;
+                    fiProp->lenVal  = (ptr) ? length - 1 : 0;
+                    fiProp->version = fiProp->version + 1;
+                    fiProp->type    = E_INI_V_STRING;
+                }
+            }
+        }
+
+        if ( (ret == 0) && (hIni->journal != NULL) ) {
+            ret = fiJournalAppend(hIni->journal, sect, key, value);
+        }
+    }
+
+    return ret;
+}
+
+
+int fiSectionIter(stFIHandle *hIni, stFIIter *iter)
+{
+    int ret = 0;
+
+    if (iter == NULL) {
+        lWrn("Is Not exist iterator!!!");
+        ret = -EINVAL;
+    }
+    else {
+        iter->node  = (hIni) ? hIni->head : NULL;
+        iter->item  = NULL;
+        iter->hIni  = NULL;
+        iter->child = NULL;
+
+        if (hIni == NULL) {
+            lWrn("Is Not exist handle!!!");
+            ret = -EINVAL;
+        }
+    }
+
+    return ret;
+}
+
+int fiSectionNext(stFIIter *iter, const char **name, size_t *len)
+{
+    int ret = -ENOENT;
+
+    stFINode     *head  = NULL;
+    stFISection  *sect  = NULL;
+    stFITreeNode *child = NULL;
+
+    if (iter == NULL) {
+        lWrn("Is Not exist iterator!!!");
+        ret = -EINVAL;
+    }
+    else if (iter->child != NULL) {
+        child = iter->child;
+
+        if (name) { *name = child->path; }
+        if (len)  { *len  = child->lenPath; }
+
+        iter->child = child->next;
+        iter->item  = child->sect;
+        ret = 0;
+    }
+    else {
+        head = iter->node;
+        while ( (head != NULL) && (head->cfg.type != E_INI_T_SECTION) ) {
+            head = head->next;
+        }
+
+        if (head != NULL) {
+            sect = (stFISection *)head->value;
+
+            if (name) { *name = (sect->name) ? sect->name : ""; }
+            if (len)  { *len  = sect->lenName; }
+
+            iter->node = head->next;
+            iter->item = sect;
+            ret = 0;
+        }
+        else {
+            iter->node = NULL;
+            iter->item = NULL;
+        }
+    }
+
+    return ret;
+}
+
+int fiSectionKeys(const stFIIter *sectIter, stFIIter *iter)
+{
+    int ret = 0;
+
+    stFISection *sect = NULL;
+
+    if ( (sectIter == NULL) || (iter == NULL) ) {
+        lWrn("Is Not exist iterator!!!");
+        ret = -EINVAL;
+    }
+    else {
+        sect = (stFISection *)sectIter->item;
+
+        iter->node = (sect) ? sect->hIni->head : NULL;
+        iter->item = NULL;
+        iter->hIni = NULL;
+
+        if (sect == NULL) {
+            ret = -ENOENT;
+        }
+    }
+
+    return ret;
+}
+
+int fiKeyIter(stFIHandle *hIni, const char *sect, stFIIter *iter)
+{
+    int ret = 0;
+
+    stFISection *fiSect = NULL;
+
+    if (iter == NULL) {
+        lWrn("Is Not exist iterator!!!");
+        ret = -EINVAL;
+    }
+    else {
+        iter->node = NULL;
+        iter->item = NULL;
+        iter->hIni = NULL;
+
+        if (hIni == NULL) {
+            lWrn("Is Not exist handle!!!");
+            ret = -EINVAL;
+        }
+        else {
+            fiSect = fiFindSection(hIni, (sect) ? sect : "");
+            if (fiSect) {
+                iter->node = fiSect->hIni->head;
+            }
+            else {
+                ret = -ENOENT;
+            }
+        }
+    }
+
+    return ret;
+}
+
+int fiKeyNext(stFIIter *iter, const char **key, size_t *lenKey, const char **val, size_t *lenVal)
+{
+    int ret = -ENOENT;
+
+    stFINode     *head = NULL;
+    stFIProperty *prop = NULL;
+
+    if (iter == NULL) {
+        lWrn("Is Not exist iterator!!!");
+        ret = -EINVAL;
+    }
+    else if (iter->hIni != NULL) {
+        if ( (iter->hIni->order != NULL)
+          && (iter->pos < iter->end) && (iter->pos < iter->hIni->order->count) ) {
+            prop = iter->hIni->order->item[iter->pos];
+
+            if (key)    { *key    = prop->key; }
+            if (lenKey) { *lenKey = prop->lenKey; }
+            if (val)    { *val    = (prop->val) ? prop->val : ""; }
+            if (lenVal) { *lenVal = prop->lenVal; }
+
+            iter->pos  = iter->pos + 1;
+            iter->item = prop;
+            ret = 0;
+        }
+        else {
+            iter->item = NULL;
+        }
+    }
+    else {
+        head = iter->node;
+        while ( (head != NULL) && (head->cfg.type != E_INI_T_PROPERTY) ) {
+            head = head->next;
+        }
+
+        if (head != NULL) {
+            prop = (stFIProperty *)head->value;
+
+            if (key)    { *key    = prop->key; }
+            if (lenKey) { *lenKey = prop->lenKey; }
+            if (val)    { *val    = (prop->val) ? prop->val : ""; }
+            if (lenVal) { *lenVal = prop->lenVal; }
+
+            iter->node = head->next;
+            iter->item = prop;
+            ret = 0;
+        }
+        else {
+            iter->node = NULL;
+            iter->item = NULL;
+        }
+    }
+
+    return ret;
+}
+
+int fiGetRangeCursor(stFIHandle *hIni, const char *sect, stFIIter *iter, stFIOrder **order)
+{
+    int ret = 0;
+
+    stFISection *fiSect = NULL;
+
+    *order = NULL;
+
+    if (iter == NULL) {
+        lWrn("Is Not exist iterator!!!");
+        ret = -EINVAL;
+    }
+    else {
+        iter->node = NULL;
+        iter->item = NULL;
+        iter->hIni = NULL;
+        iter->pos  = 0;
+        iter->end  = 0;
+
+        if (hIni == NULL) {
+            lWrn("Is Not exist handle!!!");
+            ret = -EINVAL;
+        }
+        else {
+            fiSect = fiFindSection(hIni, (sect) ? sect : "");
+            if (fiSect == NULL) {
+                ret = -ENOENT;
+            }
+            else if ( (fiSect->hIni->order == NULL) && ((fiSect = fiOwnSectionOf(hIni, (sect) ? sect : "")) == NULL) ) {
+                lWrn("fiOwnSectionOf() failed!!!");
+                ret = -ENOMEM;
+            }
+            else if ( (*order = fiOrderBuild(fiSect->hIni)) == NULL) {
+                lWrn("fiOrderBuild() failed!!!");
+                ret = -ENOMEM;
+            }
+            else {
+                iter->hIni = fiSect->hIni;
+            }
+        }
+    }
+
+    return ret;
+}
+
+int fiGetPrefix(stFIHandle *hIni, const char *sect, const char *prefix, stFIIter *iter)
+{
+    int ret = 0;
+
+    size_t length = 0;
+
+    stFIOrder *order = NULL;
+
+    ret = fiGetRangeCursor(hIni, sect, iter, &order);
+    if (ret == 0) {
+        if (prefix == NULL) { prefix = ""; }
+        length = strlen(prefix);
+
+        iter->pos = fiOrderBound(order, prefix, length, 0, 1);
+        iter->end = fiOrderBound(order, prefix, length, 1, 1);
+    }
+
+    return ret;
+}
+
+int fiGetRange(stFIHandle *hIni, const char *sect, const char *first, const char *last, stFIIter *iter)
+{
+    int ret = 0;
+
+    stFIOrder *order = NULL;
+
+    ret = fiGetRangeCursor(hIni, sect, iter, &order);
+    if (ret == 0) {
+        iter->pos = (first) ? fiOrderBound(order, first, strlen(first), 0, 0) : 0;
+        iter->end = (last)  ? fiOrderBound(order, last,  strlen(last),  0, 0) : order->count;
+
+        if (iter->end < iter->pos) {
+            iter->end = iter->pos;
+        }
+    }
+
+    return ret;
+}
+
+int fiShmSortSection(const void *a, const void *b)
+{
+    const stFISection *sectA = *(const stFISection **)a,
+                      *sectB = *(const stFISection **)b;
+
+    return fiOrderCompare((sectA->name) ? sectA->name : "", sectA->lenName,
+                          (sectB->name) ? sectB->name : "", sectB->lenName);
+}
+
+typedef struct STRUCT_INI_SHM_SORT {
+    stFIProperty *prop;
+    size_t        pos;
+} stFIShmSort;
+
+int fiShmSortKey(const void *a, const void *b)
+{
+    const stFIShmSort *sortA = (const stFIShmSort *)a,
+                      *sortB = (const stFIShmSort *)b;
+
+    int ret = fiOrderCompare(sortA->prop->key, sortA->prop->lenKey, sortB->prop->key, sortB->prop->lenKey);
+
+    if (ret == 0) {
+        // Keep the file order of duplicate keys, fiGet() returns the first one
+        ret = (sortA->pos > sortB->pos) - (sortA->pos < sortB->pos);
+    }
+
+    return ret;
+}
+
+int fiShmMapCtrl(const char *name, int oflag, stFIShmCtrl **ctrl)
+{
+    int ret = 0,
+        fd  = -1;
+
+    void *ptr = NULL;
+
+    fd = shm_open(name, oflag, (mode_t)00644);
+    if (fd == -1) {
+        ret = -errno;
+    }
+    else {
+        if ( (oflag & O_CREAT) && (ftruncate(fd, sizeof(stFIShmCtrl)) == -1) ) {
+            lErr("%s ftruncate() failed...", name);
+            ret = -EFAULT;
+        }
+        else {
+            ptr = mmap(NULL, sizeof(stFIShmCtrl), ((oflag & O_ACCMODE) == O_RDWR) ? PROT_READ | PROT_WRITE : PROT_READ,
+                       MAP_SHARED, fd, 0);
+            if (ptr == MAP_FAILED) {
+                lErr("%s mmap() failed...", name);
+                ret = -EFAULT;
+            }
+            else {
+                *ctrl = (stFIShmCtrl *)ptr;
+            }
+        }
+        close(fd);
     }
-    else if (str == NULL) {
-        lWrn("Text line is empty!!!");
+
+    return ret;
+}
+
+/* Lays out header, section table, key tables and string pool in one image */
+size_t fiShmLayout(stFISection **sect, size_t countSect, stFIProperty **prop, size_t *countKey,
+                   uint8_t *image, uint64_t generation)
+{
+    size_t idx = 0,
+           key = 0,
+           offKey = 0,
+           offStr = 0,
+           total  = 0;
+
+    stFIShmHeader *header = (stFIShmHeader *)image;
+    stFIShmEntry  *entry  = NULL;
+
+    for (idx = 0; idx < countSect; idx++) {
+        total = total + countKey[idx];
+    }
+
+    offKey = sizeof(stFIShmHeader) + countSect * sizeof(stFIShmEntry);
+    offStr = offKey + total * sizeof(stFIShmEntry);
+
+    if (image) {
+        header->magic      = FI_SHM_MAGIC;
+        header->countSect  = (uint32_t)countSect;
+        header->generation = generation;
+    }
+
+    total = 0;
+    for (idx = 0; idx < countSect; idx++) {
+        if (image) {
+            entry = &((stFIShmEntry *)&header[1])[idx];
+            entry->offName = (uint32_t)offStr;
+            entry->lenName = (uint32_t)sect[idx]->lenName;
+            entry->offData = (uint32_t)(offKey + total * sizeof(stFIShmEntry));
+            entry->lenData = (uint32_t)countKey[idx];
+
+            if (sect[idx]->name) { memcpy(&image[offStr], sect[idx]->name, sect[idx]->lenName); }
+            image[offStr + sect[idx]->lenName] = 0x00;
+        }
+        offStr = offStr + sect[idx]->lenName + 1;
+
+        for (key = 0; key < countKey[idx]; key++, prop++) {
+            if (image) {
+                entry = &((stFIShmEntry *)&image[offKey])[total + key];
+                entry->offName = (uint32_t)offStr;
+                entry->lenName = (uint32_t)(*prop)->lenKey;
+                entry->offData = (uint32_t)(offStr + (*prop)->lenKey + 1);
+                entry->lenData = (uint32_t)(*prop)->lenVal;
+
+                memcpy(&image[offStr], (*prop)->key, (*prop)->lenKey + 1);
+                if ((*prop)->val) { memcpy(&image[entry->offData], (*prop)->val, (*prop)->lenVal); }
+                image[entry->offData + (*prop)->lenVal] = 0x00;
+            }
+            offStr = offStr + (*prop)->lenKey + (*prop)->lenVal + 2;
+        }
+        total = total + countKey[idx];
+    }
+
+    if (image) {
+        header->size = offStr;
+    }
+
+    return offStr;
+}
+
+int fiShmPublish(const char *name, stFIHandle *hIni)
+{
+    int ret = 0,
+        fd  = -1;
+
+    size_t countSect = 0,
+           countProp = 0,
+           idx  = 0,
+           size = 0;
+
+    uint64_t generation = 0;
+
+    char path[FI_SHM_NAME + 24] = {0,};
+
+    void *image = MAP_FAILED;
+
+    stFINode      *head = NULL,
+                  *node = NULL;
+    stFISection  **sect = NULL;
+    stFIProperty **prop = NULL,
+                 **item = NULL;
+    stFIShmSort   *sort = NULL;
+    size_t        *countKey = NULL;
+    stFIShmCtrl   *ctrl = NULL;
+
+    if ( (name == NULL) || (strlen(name) >= FI_SHM_NAME) ) {
+        lWrn("Shared memory name invalid!!!");
+        ret = -EINVAL;
+    }
+    else if (hIni == NULL) {
+        lWrn("Is Not exist handle!!!");
         ret = -EINVAL;
     }
+    else if ( (ret = fiShmMapCtrl(name, O_RDWR | O_CREAT, &ctrl)) != 0 ) {
+        lErr("%s shm_open() failed...", name);
+    }
     else {
-        if (hIni->tail) {
-            if (hIni->tail->cfg.type == E_INI_T_SECTION) {
-                sect = (stFISection *)hIni->tail->value;
+        for (head = hIni->head; head != NULL; head = head->next) {
+            if (head->cfg.type != E_INI_T_SECTION) { continue; }
+
+            countSect = countSect + 1;
+            for (node = ((stFISection *)head->value)->hIni->head; node != NULL; node = node->next) {
+                if (node->cfg.type == E_INI_T_PROPERTY) { countProp = countProp + 1; }
             }
         }
 
-        if (sect == NULL) {
-            sect = fiSearchSection(hIni, "");
-            if (sect == NULL) {
-                lWrn("fiSearchSection() failed!!!");
+        sect     = (stFISection **)malloc((countSect + 1) * sizeof(stFISection *));
+        countKey = (size_t *)malloc((countSect + 1) * sizeof(size_t));
+        prop     = (stFIProperty **)malloc((countProp + 1) * sizeof(stFIProperty *));
+        sort     = (stFIShmSort *)malloc((countProp + 1) * sizeof(stFIShmSort));
+        if ( (sect == NULL) || (countKey == NULL) || (prop == NULL) || (sort == NULL) ) {
+            lErr("Allocate failed...");
+            ret = -ENOMEM;
+        }
+        else {
+            countSect = 0;
+            for (head = hIni->head; head != NULL; head = head->next) {
+                if (head->cfg.type == E_INI_T_SECTION) { sect[countSect++] = (stFISection *)head->value; }
+            }
+            qsort(sect, countSect, sizeof(stFISection *), fiShmSortSection);
+
+            item = prop;
+            for (idx = 0; idx < countSect; idx++) {
+                countKey[idx] = 0;
+                for (node = sect[idx]->hIni->head; node != NULL; node = node->next) {
+                    if (node->cfg.type == E_INI_T_PROPERTY) {
+                        sort[countKey[idx]].prop = (stFIProperty *)node->value;
+                        sort[countKey[idx]].pos  = countKey[idx];
+                        countKey[idx] = countKey[idx] + 1;
+                    }
+                }
+                qsort(sort, countKey[idx], sizeof(stFIShmSort), fiShmSortKey);
+
+                for (countProp = 0; countProp < countKey[idx]; countProp++) {
+                    item[countProp] = sort[countProp].prop;
+                }
+                item = item + countKey[idx];
+            }
+
+            size = fiShmLayout(sect, countSect, prop, countKey, NULL, 0);
+            if (size > UINT32_MAX) {
+                lWrn("Image too large %zu", size);
+                ret = -EFBIG;
+            }
+        }
+
+        if (ret == 0) {
+            generation = __atomic_load_n(&ctrl->generation, __ATOMIC_ACQUIRE) + 1;
+            snprintf(path, sizeof(path), "%s.%llu", name, (unsigned long long)generation);
+
+            shm_unlink(path);
+            fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, (mode_t)00644);
+            if (fd == -1) {
+                lErr("%s shm_open() failed...", path);
+                ret = -EFAULT;
+            }
+            else if (ftruncate(fd, size) == -1) {
+                lErr("%s ftruncate() failed...", path);
+                ret = -EFAULT;
+            }
+            else if ( (image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED ) {
+                lErr("%s mmap() failed...", path);
                 ret = -EFAULT;
             }
+            else {
+                fiShmLayout(sect, countSect, prop, countKey, (uint8_t *)image, generation);
+                munmap(image, size);
+
+                // Publish, then drop the name of the previous image(mapped readers keep it)
+                ctrl->magic = FI_SHM_MAGIC;
+                __atomic_store_n(&ctrl->generation, generation, __ATOMIC_RELEASE);
+
+                snprintf(path, sizeof(path), "%s.%llu", name, (unsigned long long)(generation - 1));
+                shm_unlink(path);
+            }
+
+            if (fd != -1) {
+                close(fd);
+                if (ret != 0) { shm_unlink(path); }
+            }
+        }
+
+        if (sect)     { free(sect); }
+        if (countKey) { free(countKey); }
+        if (prop)     { free(prop); }
+        if (sort)     { free(sort); }
+
+        munmap(ctrl, sizeof(stFIShmCtrl));
+    }
+
+    return ret;
+}
+
+int fiShmUnlink(const char *name)
+{
+    int ret = 0;
+
+    char path[FI_SHM_NAME + 24] = {0,};
+
+    stFIShmCtrl *ctrl = NULL;
+
+    if ( (name == NULL) || (strlen(name) >= FI_SHM_NAME) ) {
+        lWrn("Shared memory name invalid!!!");
+        ret = -EINVAL;
+    }
+    else {
+        if (fiShmMapCtrl(name, O_RDONLY, &ctrl) == 0) {
+            snprintf(path, sizeof(path), "%s.%llu", name,
+                     (unsigned long long)__atomic_load_n(&ctrl->generation, __ATOMIC_ACQUIRE));
+            shm_unlink(path);
+            munmap(ctrl, sizeof(stFIShmCtrl));
+        }
+
+        if (shm_unlink(name) == -1) {
+            ret = -errno;
+        }
+    }
+
+    return ret;
+}
+
+int fiShmRefresh(stFIShm *shm)
+{
+    int ret = 0,
+        fd  = -1;
+
+    uint64_t generation = 0;
+
+    char path[FI_SHM_NAME + 24] = {0,};
+
+    struct stat sb;
+
+    void *image = MAP_FAILED;
+
+    if (shm == NULL) {
+        lWrn("Is Not exist shared memory!!!");
+        ret = -EINVAL;
+    }
+    else {
+        generation = __atomic_load_n(&shm->ctrl->generation, __ATOMIC_ACQUIRE);
+        while ( (generation != 0) && (generation != shm->generation) && (ret == 0) ) {
+            snprintf(path, sizeof(path), "%s.%llu", shm->name, (unsigned long long)generation);
+
+            fd = shm_open(path, O_RDONLY, (mode_t)00644);
+            if (fd == -1) {
+                if (errno != ENOENT) {
+                    lErr("%s shm_open() failed...", path);
+                    ret = -EFAULT;
+                }
+                else if (__atomic_load_n(&shm->ctrl->generation, __ATOMIC_ACQUIRE) == generation) {
+                    // Unlinked, not republished
+                    lWrn("%s is not exist!!!", path);
+                    ret = -ENOENT;
+                }
+                else {
+                    // Republished meanwhile, follow the new generation
+                    generation = __atomic_load_n(&shm->ctrl->generation, __ATOMIC_ACQUIRE);
+                }
+                continue;
+            }
+
+            if ( (fstat(fd, &sb) == -1) || (sb.st_size < (off_t)sizeof(stFIShmHeader)) ) {
+                lWrn("%s image is invalid!!!", path);
+                ret = -EFAULT;
+            }
+            else if ( (image = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED ) {
+                lErr("%s mmap() failed...", path);
+                ret = -EFAULT;
+            }
+            else if ( (((stFIShmHeader *)image)->magic != FI_SHM_MAGIC)
+                   || (((stFIShmHeader *)image)->size  > (uint64_t)sb.st_size) ) {
+                lWrn("%s image is invalid!!!", path);
+                munmap(image, sb.st_size);
+                ret = -EFAULT;
+            }
+            else {
+                if (shm->image) {
+                    munmap(shm->image, shm->size);
+                }
+
+                shm->image      = (stFIShmHeader *)image;
+                shm->size       = sb.st_size;
+                shm->generation = generation;
+                ret = 1;
+            }
+            close(fd);
+        }
+    }
+
+    return ret;
+}
+
+stFIShm *fiShmAttach(const char *name)
+{
+    stFIShm *shm = NULL;
+
+    if ( (name == NULL) || (strlen(name) >= FI_SHM_NAME) ) {
+        lWrn("Shared memory name invalid!!!");
+    }
+    else {
+        shm = (stFIShm *)malloc(sizeof(stFIShm));
+        if (shm == NULL) {
+            lErr("Allocate failed...");
+        }
+        else {
+            snprintf(shm->name, FI_SHM_NAME, "%s", name);
+            shm->image      = NULL;
+            shm->size       = 0;
+            shm->generation = 0;
+
+            if (fiShmMapCtrl(name, O_RDONLY, &shm->ctrl) != 0) {
+                lErr("%s shm_open() failed...", name);
+                free(shm);
+                shm = NULL;
+            }
+            else if (fiShmRefresh(shm) < 0) {
+                fiShmDetach(shm);
+                shm = NULL;
+            }
+        }
+    }
+
+    return shm;
+}
+
+void fiShmDetach(stFIShm *shm)
+{
+    if (shm) {
+        if (shm->image) {
+            munmap(shm->image, shm->size);
+        }
+        munmap(shm->ctrl, sizeof(stFIShmCtrl));
+
+        free(shm);
+    }
+}
+
+uint64_t fiShmGeneration(stFIShm *shm)
+{
+    return (shm) ? shm->generation : 0;
+}
+
+/* First entry equal to str in a sorted entry table, NULL if not found */
+stFIShmEntry *fiShmFind(const uint8_t *image, stFIShmEntry *table, size_t count, const char *str)
+{
+    size_t low  = 0,
+           high = count,
+           mid  = 0,
+           len  = strlen(str);
+
+    while (low < high) {
+        mid = low + ((high - low) >> 1);
+        if (fiOrderCompare((const char *)&image[table[mid].offName], table[mid].lenName, str, len) < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    if ( (low < count)
+      && (fiOrderCompare((const char *)&image[table[low].offName], table[low].lenName, str, len) == 0) ) {
+        return &table[low];
+    }
+
+    return NULL;
+}
+
+const char *fiShmGet(stFIShm *shm, const char *sect, const char *key)
+{
+    const char *value = NULL;
+
+    const uint8_t *image = NULL;
+    stFIShmEntry  *entry = NULL;
+
+    if ( (shm == NULL) || (shm->image == NULL) ) {
+        lWrn("Is Not exist shared memory!!!");
+    }
+    else if (key) {
+        image = (const uint8_t *)shm->image;
+
+        entry = fiShmFind(image, (stFIShmEntry *)&shm->image[1], shm->image->countSect, (sect) ? sect : "");
+        if (entry) {
+            entry = fiShmFind(image, (stFIShmEntry *)&image[entry->offData], entry->lenData, key);
+            if (entry) {
+                value = (const char *)&image[entry->offData];
+            }
+        }
+    }
+
+    return value;
+}
+
+/* Node of dst matching a section or property node of src, hashed for the mode of dst */
+stFINode *fiMergeFind(stFIHandle *dst, stFINode *node, uint32_t flags)
+{
+    const char *key = NULL;
+
+    size_t   size = 0;
+    uint32_t hash = 0;
+
+    if (fiNodeKey(node, &key, &size, &hash) != 0) {
+        return NULL;
+    }
+
+    if ( (flags ^ dst->flags) & FI_OPT_NOCASE ) {
+        hash = fiHashName(dst->flags, key, size);
+    }
+
+    return fiFindNode(dst, node->cfg.type, key, size, hash);
+}
+
+/* E_INI_M_ERROR : a key of src with another value in dst */
+int fiMergeConflict(stFIHandle *dst, stFIHandle *src)
+{
+    stFINode     *node = NULL,
+                 *item = NULL,
+                 *dstNode = NULL,
+                 *dstItem = NULL;
+    stFISection  *sect = NULL;
+    stFIProperty *prop = NULL,
+                 *dstProp = NULL;
+
+    for (node = src->head; node != NULL; node = node->next) {
+        if ( (node->cfg.type != E_INI_T_SECTION) || ((dstNode = fiMergeFind(dst, node, src->flags)) == NULL) ) {
+            continue;
+        }
+
+        sect = (stFISection *)node->value;
+        for (item = sect->hIni->head; item != NULL; item = item->next) {
+            if ( (item->cfg.type != E_INI_T_PROPERTY) || (fiPropertyVisible(sect->hIni, item) == 0) ) {
+                continue;
+            }
+
+            dstItem = fiMergeFind(((stFISection *)dstNode->value)->hIni, item, sect->hIni->flags);
+            if (dstItem) {
+                prop    = (stFIProperty *)item->value;
+                dstProp = (stFIProperty *)dstItem->value;
+                if ( (prop->lenVal != dstProp->lenVal)
+                  || ((prop->lenVal > 0) && (memcmp(prop->val, dstProp->val, prop->lenVal) != 0)) ) {
+                    lWrn("[%s] %s conflicts", (sect->name) ? sect->name : "", prop->key);
+                    return -EEXIST;
+                }
+            }
         }
+    }
+
+    return 0;
+}
+
+int fiMerge(stFIHandle *dst, stFIHandle *src, int policy)
+{
+    int ret = 0;
+
+    char *val = NULL;
+
+    uint32_t flags = 0;
+
+    stFINode     *node = NULL,
+                 *dstNode = NULL,
+                 *item = NULL,
+                 *next = NULL;
+    stFISection  *sect = NULL,
+                 *dstSect = NULL;
+    stFIProperty *prop = NULL,
+                 *dstProp = NULL;
+
+    if ( (dst == NULL) || (src == NULL) || (dst == src) ) {
+        lWrn("Is Not exist handle!!!");
+        return -EINVAL;
+    }
+
+    if ( (policy != E_INI_M_OVERWRITE) && (policy != E_INI_M_KEEP) && (policy != E_INI_M_ERROR) ) {
+        lWrn("Merge policy(%d) invalid!!!", policy);
+        return -EINVAL;
+    }
+
+    // Checked before anything moves, a conflict leaves both handles as they were
+    if ( (policy == E_INI_M_ERROR) && ((ret = fiMergeConflict(dst, src)) != 0) ) {
+        return ret;
+    }
+
+    while ( (ret == 0) && ((node = src->head) != NULL) ) {
+        dstNode = (node->cfg.type == E_INI_T_SECTION) ? fiMergeFind(dst, node, src->flags) : NULL;
+
+        fiRemoveNode(src, node);
+
+        if (dstNode == NULL) {
+            // Spliced, a shared section is copied only when its names must be rehashed
+            if ( (node->cfg.type == E_INI_T_SECTION) && ((dst->flags ^ src->flags) & FI_OPT_NOCASE)
+              && (fiOwnSection(node) == NULL) ) {
+                fiDestroyValue(node->cfg.type, node->value);
+                free(node);
+                ret = -ENOMEM;
+                break;
+            }
+
+            fiInsertNode(dst, node);
+            continue;
+        }
+
+        // A section shared with a clone is copied instead of moved
+        dstSect = fiOwnSection(dstNode);
+        sect    = fiOwnSection(node);
+        if ( (dstSect == NULL) || (sect == NULL) ) {
+            ret = -ENOMEM;
+        }
+
+        // Later duplicates E_INI_D_FIRST keeps are hidden from fiGet(), they must not win here
+        for (item = (ret == 0) ? sect->hIni->head : NULL; item != NULL; item = next) {
+            next = item->next;
+            if ( (item->cfg.type == E_INI_T_PROPERTY) && (fiPropertyVisible(sect->hIni, item) == 0) ) {
+                fiRemoveNode(sect->hIni, item);
+                fiDestroyValue(item->cfg.type, item->value);
+                free(item);
+            }
+        }
+
+        flags = (sect) ? sect->hIni->flags : 0;
+        while ( (ret == 0) && ((item = sect->hIni->head) != NULL) ) {
+            dstProp = NULL;
+            if (item->cfg.type == E_INI_T_PROPERTY) {
+                dstProp = (stFIProperty *)fiMergeFind(dstSect->hIni, item, flags);
+                if (dstProp) { dstProp = (stFIProperty *)((stFINode *)dstProp)->value; }
+            }
+
+            fiRemoveNode(sect->hIni, item);
+
+            if (dstProp == NULL) {
+                if ( (item->cfg.type == E_INI_T_PROPERTY) && ((flags ^ dstSect->hIni->flags) & FI_OPT_NOCASE) ) {
+                    prop       = (stFIProperty *)item->value;
+                    prop->hash = fiHashName(dstSect->hIni->flags, prop->key, prop->lenKey);
+                }
+
+                fiInsertNode(dstSect->hIni, item);
+                continue;
+            }
+
+            if (policy == E_INI_M_OVERWRITE) {
+                prop = (stFIProperty *)item->value;
+
+                val              = dstProp->val;
+                dstProp->val     = prop->val;
+                dstProp->lenVal  = prop->lenVal;
+                dstProp->version = dstProp->version + 1;
+                dstProp->type    = prop->type;
+                dstProp->typed   = prop->typed;
+                prop->val        = val;
+            }
+
+            fiDestroyValue(item->cfg.type, item->value);
+            free(item);
+        }
+
+        fiDestroyValue(node->cfg.type, node->value);
+        free(node);
+    }
+
+    dst->epoch = fiNextEpoch();
+    src->epoch = fiNextEpoch();
+
+    return ret;
+}
+
+int fiLoadSort(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+int fiLoadSortVersion(const void *a, const void *b)
+{
+    return strverscmp(*(char * const *)a, *(char * const *)b);
+}
+
+void *fiLoadWorker(void *arg)
+{
+    size_t idx = 0;
+
+    char path[FI_BUFFER_SIZE] = {0,};
+
+    stFILoader *loader = (stFILoader *)arg;
+
+    while ( (idx = __atomic_fetch_add(&loader->next, 1, __ATOMIC_RELAXED)) < loader->count ) {
+        snprintf(path, FI_BUFFER_SIZE, "%s/%s", loader->path, loader->name[idx]);
+        loader->hIni[idx] = fiFileRead(path);
+    }
+
+    return NULL;
+}
+
+/* Journal and compaction files next to a fragment, fiFileRead() replays the journal itself */
+int fiLoadSidecar(const char *name)
+{
+    static const char *suffix[] = { FI_JOURNAL_SUFFIX, FI_COMPACT_SUFFIX, NULL };
+
+    size_t idx    = 0,
+           length = strlen(name),
+           lenSfx = 0;
 
-        if (sect) {
-            fiInsert(sect->hIni, E_INI_T_PROPERTY, str, size);
+    for (idx = 0; suffix[idx] != NULL; idx++) {
+        lenSfx = strlen(suffix[idx]);
+        if ( (length > lenSfx) && (strcmp(&name[length - lenSfx], suffix[idx]) == 0) ) {
+            return 1;
         }
     }
 
-    return ret;
+    return 0;
 }
 
-int fiProcType(const char *str, size_t size)
+stFIHandle *fiLoadDirectory(const char *path, const char *pattern, int order)
 {
-    int ret = E_INI_T_UNKNOWN;
+    size_t idx = 0,
+           size = 0,
+           countThread = 0;
 
-    char *semicolon = strchr(str, ';');
-    char *hash      = strchr(str, '#');
+    long   cpus = 0;
 
-    char *square  = strchr(str, '[');
-    char *equals  = strchr(str, '=');
-    char *comment = NULL;
+    char **name = NULL;
 
-    if (semicolon || hash) {
-        if (semicolon && hash) { comment = (semicolon < hash) ? semicolon : hash; }
-        else if (semicolon)    { comment = semicolon; }
-        else                   { comment = hash; }
-    }
+    DIR           *dir = NULL;
+    struct dirent *ent = NULL;
 
-    if ( square && (strchr(str, ']') == NULL) ) {
-        square = NULL;
-    }
+    pthread_t   thread[FI_LOAD_THREADS];
+    stFILoader  loader;
+    stFIHandle *hIni = NULL;
 
-    if ( square ) {
-        if ( comment ) {
-            ret = ( square < comment ) ? E_INI_T_SECTION : E_INI_T_COMMENT;
-        }
-        else {
-            ret = E_INI_T_SECTION;
-        }
+    memset(&loader, 0, sizeof(stFILoader));
+
+    if (path == NULL) {
+        lWrn("Directory path is not exist!!!");
     }
-    else if ( equals ) {
-        if ( comment ) {
-            ret = ( equals < comment ) ? E_INI_T_PROPERTY : E_INI_T_COMMENT;
-        }
-        else {
-            ret = E_INI_T_PROPERTY;
-        }
+    else if ( (dir = opendir(path)) == NULL ) {
+        lErr("opendir(%s) failed...", path);
     }
     else {
-        if ( comment ) {
-            ret = E_INI_T_COMMENT;
-        }
-    }
+        while ( (ent = readdir(dir)) != NULL ) {
+            if ( (ent->d_type != DT_REG) && (ent->d_type != DT_LNK) && (ent->d_type != DT_UNKNOWN) ) { continue; }
+            if (ent->d_name[0] == '.') { continue; }
+            if (fiLoadSidecar(ent->d_name)) { continue; }
+            if ( pattern && (fnmatch(pattern, ent->d_name, FNM_PERIOD) != 0) ) { continue; }
+
+            if (loader.count == size) {
+                size = size + FI_ORDER_GROW;
+                name = (char **)realloc(loader.name, size * sizeof(char *));
+                if (name == NULL) {
+                    lErr("Allocate failed...");
+                    break;
+                }
+                loader.name = name;
+            }
 
-    return ret;
-}
+            loader.name[loader.count] = strdup(ent->d_name);
+            if (loader.name[loader.count] == NULL) {
+                lErr("Allocate failed...");
+                break;
+            }
+            loader.count = loader.count + 1;
+        }
+        closedir(dir);
 
-stFIHandle *fiProcRead(int fd)
-{
-    size_t offset = 0,
-           offOld = 0,
-           offTok = 0;
+        if (ent == NULL) {
+            hIni = fiInit();
+        }
 
-    size_t szRead = 0,
-           szLine = 0;
+        if ( hIni && (loader.count > 0) ) {
+            qsort(loader.name, loader.count, sizeof(char *), (order == E_INI_O_VERSION) ? fiLoadSortVersion : fiLoadSort);
 
-    char delmit[4] = {"\r\n"};
-	char ptr[FI_BUFFER_SIZE] = {0,};
+            loader.path = path;
+            loader.hIni = (stFIHandle **)calloc(loader.count, sizeof(stFIHandle *));
+            if (loader.hIni == NULL) {
+                lErr("Allocate failed...");
+                fiDestroy(hIni);
+                hIni = NULL;
+            }
+            else {
+                cpus = sysconf(_SC_NPROCESSORS_ONLN);
 
-    char *old = NULL,
-         *tok = NULL;
+                countThread = (cpus > 0) ? (size_t)cpus : 1;
+                if (countThread > FI_LOAD_THREADS) { countThread = FI_LOAD_THREADS; }
+                if (countThread > loader.count)    { countThread = loader.count; }
 
-    stFIHandle *hIni = NULL;
+                // The calling thread is one of the workers
+                for (idx = 1; idx < countThread; idx++) {
+                    if (pthread_create(&thread[idx], NULL, fiLoadWorker, &loader) != 0) {
+                        lErr("pthread_create() failed...");
+                        break;
+                    }
+                }
+                countThread = idx;
 
-	if (fd == -1) {
-        lWrn("Ini file descriptor invaild!!!");
-    }
-    else {
-		lseek(fd, 0, SEEK_SET);
+                fiLoadWorker(&loader);
+                for (idx = 1; idx < countThread; idx++) {
+                    pthread_join(thread[idx], NULL);
+                }
 
-        hIni = fiInit();
-        while (hIni
-            && ((szRead = read(fd, &ptr[offset], FI_BUFFER_SIZE - offset)) > 0) ) {
-//              lDbg("read size = %d, offset=%d", (int)szRead, (int)offset);
-            szRead = szRead + offset;
-//              hexdump("Before test", ptr, szRead);
-
-            offset = 0;
-            tok = strtok_r(&ptr[0], delmit, &old);
-            while (tok != NULL) {
-                offTok = tok - ptr;
-                offOld = old - ptr;
-
-//                  lDbg("Offset=(%d, R=%d, T=%d, O=%d)", (int)offset, (int)szRead, (int)offTok, (int)offOld);
-                while (offset < offTok) {
-                    if ( (ptr[offset] == 0x0D) // CR \r
-                      || (ptr[offset] == 0x0A) ) { // LF \n
-//                          lDbg("E_INI_T_BLANK");
-                        fiInsert(hIni, E_INI_T_BLANK, NULL, 0);
-
-                        if ( (ptr[offset + 0] == 0x0D)
-                          && (ptr[offset + 1] == 0x0A) ) { offset = offset + 2; }
-                        else                             { offset = offset + 1; }
+                for (idx = 0; idx < loader.count; idx++) {
+                    if (loader.hIni[idx] == NULL) {
+                        lWrn("%s/%s skipped", path, loader.name[idx]);
                     }
                     else {
-                        lWrn("Unknown Ignore %c", (char)ptr[offset]);
-                        offset = offset + 1;
+                        fiMerge(hIni, loader.hIni[idx], E_INI_M_OVERWRITE);
+                        fiDestroy(loader.hIni[idx]);
                     }
                 }
+            }
+        }
 
-                if (ptr[offOld - 1] == 0) {
-                    szLine = strlen(tok);
-//                      lDbg("Line(%d) = %s", (int)szLine, tok);
-
-                    switch( fiProcType(tok, szLine) ) {
-                    case E_INI_T_SECTION  : fiInsertSection(hIni, tok, szLine);  break;
-                    case E_INI_T_PROPERTY : fiInsertProperty(hIni, tok, szLine); break;
-                    case E_INI_T_COMMENT  : fiInsertComment(hIni, tok, szLine);  break;
-                    case E_INI_T_BLANK    :
-                    case E_INI_T_UNKNOWN  :
-                    default               : break;
-                    }
+        for (idx = 0; idx < loader.count; idx++) {
+            free(loader.name[idx]);
+        }
+        if (loader.name) { free(loader.name); }
+        if (loader.hIni) { free(loader.hIni); }
+    }
 
-                    offset = offOld + ((ptr[offOld] == 0x0A) ? 1 : 0);
-                    tok = (offOld < szRead) ? strtok_r(NULL, delmit, &old) : NULL;
-                }
-                else {
-                    tok = NULL;
-                }
-            }
+    return hIni;
+}
+
+/* Owner side : cuts a torn tail under LOCK_EX, records appended later would sit behind it */
+int fiJournalTrim(int fd, const char *path)
+{
+    int ret = 0;
 
-            if (szRead > offset) {
-                offTok = szRead - offset;
-//              hexdump("After test", ptr, szRead);
-//              lDbg("read=%d, elapse=%d, reamin=%d", (int)szRead, (int)offset, (int)offTok );
+    off_t  size  = 0;
+    size_t valid = 0;
 
-                memmove(&ptr[0], &ptr[offset], offTok);
-                offset = offTok;
+    while ( (flock(fd, LOCK_EX) == -1) && (errno == EINTR) );
+
+    ret = fiJournalScan(fd, path, NULL, &valid);
+    if (ret == 0) {
+        size = lseek(fd, 0, SEEK_END);
+        if ( (size != (off_t)-1) && ((size_t)size > valid) ) {
+            if (ftruncate(fd, valid) == -1) {
+                lErr("%s ftruncate(%zu) failed...", path, valid);
+                ret = -EIO;
             }
-            else {
-                offset = 0;
+            else if (fsync(fd) == -1) {
+                lErr("%s fsync() failed...", path);
+                ret = -EIO;
             }
         }
     }
 
-    return hIni;
+    flock(fd, LOCK_UN);
+
+    return ret;
 }
 
-int fiProcSave(int fd, stFIHandle *hIni)
+int fiJournalOpen(stFIHandle *hIni, const char *file, uint32_t flags)
 {
     int ret = 0;
 
-	char ptr[FI_BUFFER_SIZE] = {0,};
+    char *path = NULL;
 
-    stFINode     *head = NULL,
-                 *next = NULL;
-    stFISection  *sect = NULL;
-    stFIProperty *prop = NULL;
+    stFIJournal *journal = NULL;
 
     if (hIni == NULL) {
         lWrn("Is Not exist handle!!!");
         ret = -EINVAL;
     }
-    else if (fd == -1) {
-        lWrn("Save file descriptor invaoild!!!");
+    else if (file == NULL) {
+        lWrn("Journal file is not exist!!!");
         ret = -EINVAL;
     }
+    else if ( (journal = (stFIJournal *)malloc(sizeof(stFIJournal))) == NULL ) {
+        lErr("Allocate failed...");
+        ret = -ENOMEM;
+    }
     else {
-        head = (stFINode *)hIni->head;
-        while ( head != NULL ) {
-            next = head->next;
-            switch(head->cfg.type) {
-            case E_INI_T_SECTION  :
-                sect = (stFISection *)head->value;
-                if (sect->name) {
-                    snprintf(ptr, FI_BUFFER_SIZE, "[%s]" FI_LINE, sect->name);
-                    write(fd, ptr, strlen(ptr));
-                }
-                fiProcSave(fd, sect->hIni);
-                break;
-
-            case E_INI_T_PROPERTY :
-                prop = (stFIProperty *)head->value;
-                snprintf(ptr, FI_BUFFER_SIZE, "%s = %s" FI_LINE, prop->key, prop->val);
-                write(fd, ptr, strlen(ptr));
-                break;
-
-            case E_INI_T_COMMENT  :
-                snprintf(ptr, FI_BUFFER_SIZE, "; %s" FI_LINE, (char *)head->value);
-                write(fd, ptr, strlen(ptr));
-                break;
-
-            case E_INI_T_BLANK    : write(fd, FI_LINE, strlen(FI_LINE)); break;
-            case E_INI_T_UNKNOWN  :
-            default               : break;
-            }
+        journal->flags = flags;
+        journal->file  = strdup(file);
+        path           = fiJournalPath(file);
+
+        journal->fd = (path) ? open(path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, (mode_t)00666) : -1;
+        if ( (journal->fd != -1) && ((ret = fiJournalTrim(journal->fd, path)) != 0) ) {
+            close(journal->fd);
+            journal->fd = -1;
+        }
 
-            head = next;
+        if ( (journal->file == NULL) || (journal->fd == -1) ) {
+            lErr("%s open() failed...", (path) ? path : file);
+            if (journal->fd != -1) { close(journal->fd); }
+            if (journal->file)     { free(journal->file); }
+            free(journal);
+            if (ret == 0) { ret = -EFAULT; }
+        }
+        else {
+            fiJournalClose(hIni);
+            hIni->journal = journal;
         }
+
+        if (path) { free(path); }
     }
 
     return ret;
 }
 
-int fiFileSave(const char *file, stFIHandle *hIni)
+/* fsync() of the directory holding file, so a rename() into it is durable */
+int fiSyncDir(const char *file)
 {
-    int fd  = -1,
-        ret = 0;
+    int ret = 0,
+        fd  = -1;
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
-    }
-    else {
-        fd = open(file, O_RDWR | O_CREAT | O_TRUNC, (mode_t)00666);
-        if (fd == -1) {
-            lErr("%s open() failed...", file);
-            ret = -EFAULT;
-        }
-        else {
-		    if (lseek(fd, 0, SEEK_SET) == (off_t)-1) {
-                lErr("%s lseek( 0, SEEK_SET) failed...", file);
-            }
+    char *path = NULL,
+         *last = NULL;
 
-            fiProcSave(fd, hIni);
+    path = strdup(file);
+    if (path == NULL) {
+        lErr("Allocate failed...");
+        return -ENOMEM;
+    }
 
-            if (fsync(fd) == -1) {
-                lErr("%s fsync() failed...", file);
-            }
+    last = strrchr(path, '/');
+    if      (last == NULL) { strcpy(path, "."); }
+    else if (last == path) { path[1] = 0x00; }
+    else                   { *last = 0x00; }
 
-            if (close(fd) == -1) {
-                lErr("%s close() failed...", file);
-            }
+    fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        ret = -errno;
+        lErr("%s open() failed...", path);
+    }
+    else {
+        if (fsync(fd) == -1) {
+            lErr("%s fsync() failed...", path);
+            ret = -EIO;
         }
+        close(fd);
     }
 
+    free(path);
+
     return ret;
 }
 
-stFIHandle *fiFileRead(const char *file)
+int fiJournalCompact(stFIHandle *hIni)
 {
-    int fd  = -1;
+    int ret = 0;
 
-    struct stat sb;
+    char *path = NULL;
 
-    stFIHandle *hIni = NULL;
+    struct stat sb;
 
-    if (stat(file, &sb) == -1) {
-        lErr("stat(%s, ) failed...", file);
+    if ( (hIni == NULL) || (hIni->journal == NULL) ) {
+        lWrn("Is Not exist journal!!!");
+        ret = -EINVAL;
+    }
+    else if ( (path = (char *)malloc(strlen(hIni->journal->file) + sizeof(FI_COMPACT_SUFFIX))) == NULL ) {
+        lErr("Allocate failed...");
+        ret = -ENOMEM;
     }
     else {
-        if ( S_ISREG(sb.st_mode) ) {
-            fd = open(file, O_RDONLY, (mode_t)00666);
-            if (fd == -1) {
-                lErr("%s open failed...", file);
-            }
-            else {
-                hIni = fiProcRead(fd);
-                close(fd);
-            }
+        // The file is replaced whole, a crash leaves either the old or the new one with its journal
+        while ( (flock(hIni->journal->fd, LOCK_EX) == -1) && (errno == EINTR) );
+        snprintf(path, strlen(hIni->journal->file) + sizeof(FI_COMPACT_SUFFIX), "%s" FI_COMPACT_SUFFIX, hIni->journal->file);
+
+        ret = fiFileSave(path, hIni);
+        if ( (ret == 0) && (stat(hIni->journal->file, &sb) == 0) && (chmod(path, sb.st_mode & 07777) == -1) ) {
+            lWrn("%s chmod() failed...", path);
+        }
+
+        if ( (ret == 0) && (rename(path, hIni->journal->file) == -1) ) {
+            ret = -errno;
+            lErr("rename(%s, %s) failed...", path, hIni->journal->file);
+        }
+
+        if (ret != 0) {
+            unlink(path);
         }
         else {
-            lWrn("%s is not file Regular file", file);
+            ret = fiSyncDir(hIni->journal->file);
+        }
+
+        // Records replayed over the saved file only set the same values again
+        if (ret == 0) {
+            if (ftruncate(hIni->journal->fd, 0) == -1) {
+                lErr("%s" FI_JOURNAL_SUFFIX " ftruncate() failed...", hIni->journal->file);
+                ret = -EIO;
+            }
+            else if (fsync(hIni->journal->fd) == -1) {
+                lErr("%s" FI_JOURNAL_SUFFIX " fsync() failed...", hIni->journal->file);
+                ret = -EIO;
+            }
         }
+
+        flock(hIni->journal->fd, LOCK_UN);
+        free(path);
     }
 
-    return hIni;
+    return ret;
 }
 
-stFIProperty *fiFindProperty(stFIHandle *hIni, const char *key)
+void fiJournalClose(stFIHandle *hIni)
 {
-    stFINode *head = NULL,
-             *next = NULL;
+    if (hIni && hIni->journal) {
+        close(hIni->journal->fd);
+        free(hIni->journal->file);
+        free(hIni->journal);
 
-    stFIProperty *prop   = NULL,
-                 *fiProp = NULL;
+        hIni->journal = NULL;
+    }
+}
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
+/* Tree of hIni, rebuilt when the handle changed since it was built */
+stFITree *fiTreeGet(stFIHandle *hIni)
+{
+    if ( (hIni->tree == NULL) || (hIni->tree->epoch != hIni->epoch) ) {
+        fiTreeBuild(hIni, (hIni->tree) ? hIni->tree->separator : FI_TREE_SEPARATOR);
     }
-    else {
-        head = (stFINode *)hIni->head;
-        while ( (head != NULL) && (prop == NULL) ) {
-            next = head->next;
-            if( head->cfg.type == E_INI_T_PROPERTY ) {
-                fiProp = (stFIProperty *)head->value;
 
-                if (strcmp((const char *)fiProp->key, (const char *)key) == 0) {
-                    prop = fiProp;
-                }
-            }
-            head = next;
+    return (hIni->tree && (hIni->tree->epoch == hIni->epoch)) ? hIni->tree : NULL;
+}
+
+/* Node of the longest existing path in sect, cut on the separator */
+stFITreeNode *fiTreeNearest(stFITree *tree, const char *sect, size_t size)
+{
+    stFITreeNode *node = NULL;
+
+    while ( (node == NULL) && (size > 0) ) {
+        node = fiTreeFind(tree, sect, size, fiHashName(tree->flags, sect, size));
+        if (node == NULL) {
+            for (size = size - 1; (size > 0) && (sect[size] != tree->separator); size--);
         }
     }
 
-    return prop;
+    return node;
 }
 
-char *fiGetPropertyData(stFIHandle *hIni, const char *key)
+const char *fiSectionParent(stFIHandle *hIni, const char *sect)
 {
-    char     *value = NULL;
+    size_t size = 0;
 
-    stFIProperty *prop = NULL;
+    stFITree     *tree = NULL;
+    stFITreeNode *node = NULL;
 
-    if (hIni == NULL) {
+    if ( (hIni == NULL) || (sect == NULL) ) {
         lWrn("Is Not exist handle!!!");
     }
-    else {
-        prop = fiFindProperty(hIni, key);
-        if (prop) {
-            value = (char *)prop->val;
+    else if ( (tree = fiTreeGet(hIni)) != NULL ) {
+        size = strlen(sect);
+        node = fiTreeNearest(tree, sect, size);
+        if ( node && (node->lenPath == size) ) {
+            node = node->parent;
+        }
+
+        while ( (node != NULL) && (node->sect == NULL) ) {
+            node = node->parent;
         }
     }
 
-    return value;
+    return (node) ? node->sect->name : NULL;
 }
 
-char *fiGet(stFIHandle *hIni, const char *sect, const char *key)
+int fiSectionChildren(stFIHandle *hIni, const char *sect, stFIIter *iter)
 {
-    char *value = NULL;
+    int ret = 0;
 
-    stFISection *fiSect = NULL;
+    size_t size = 0;
 
-    if (hIni == NULL) {
+    stFITree     *tree = NULL;
+    stFITreeNode *node = NULL;
+
+    if ( (hIni == NULL) || (iter == NULL) ) {
         lWrn("Is Not exist handle!!!");
+        ret = -EINVAL;
     }
     else {
-        fiSect = (stFISection *)fiFindSection(hIni, sect);
-        if (fiSect) {
-            value = (char *)fiGetPropertyData(fiSect->hIni, key);
+        iter->node  = NULL;
+        iter->item  = NULL;
+        iter->hIni  = NULL;
+        iter->child = NULL;
+
+        size = (sect) ? strlen(sect) : 0;
+        tree = fiTreeGet(hIni);
+        if (tree == NULL) {
+            ret = -ENOMEM;
+        }
+        else if (size == 0) {
+            iter->child = tree->child;
+        }
+        else if ( (node = fiTreeFind(tree, sect, size, fiHashName(tree->flags, sect, size))) != NULL ) {
+            iter->child = node->child;
+        }
+        else {
+            ret = -ENOENT;
         }
     }
 
-    return value;
+    return ret;
 }
 
-int fiPut(stFIHandle *hIni, const char *sect, const char *key, const char *value)
+/* Keys of the section and its ancestors in one table, nearest section first */
+stFIHash *fiTreeView(stFITree *tree, stFITreeNode *node)
 {
-    int ret = 0;
-
-    size_t length = 0;
+    size_t count = 0,
+           size  = FI_HASH_MIN << 1;
 
-    char *ptr = NULL;
+    stFINode     *head = NULL;
+    stFITreeNode *walk = NULL;
+    stFIHash     *view = NULL;
 
-    stFINode *node = NULL;
+    if (node->view == NULL) {
+        for (walk = node; walk != NULL; walk = walk->parent) {
+            count = count + ((walk->sect) ? walk->sect->hIni->count : 0);
+        }
 
-    stFISection  *fiSect = NULL;
-    stFIProperty *fiProp = NULL;
+        while (size < (count << 1)) {
+            size = size << 1;
+        }
 
-    if (hIni == NULL) {
-        lWrn("Is Not exist handle!!!");
-        ret = -EINVAL;
-    }
-    else {
-        length = strlen(value) + 1;
-        fiSect = (stFISection *)fiSearchSection(hIni, sect);
-        if (fiSect) {
-            fiProp = fiFindProperty(fiSect->hIni, key);
-            if (fiProp == NULL) {
-                fiProp = (stFIProperty *)fiMakeProperty(key, (char *)value);
-                if (fiProp == NULL) {
-                    lWrn("fiMakeProperty() failed!!!");
-                    ret = -EFAULT;
-                }
-                else {
-                    node = (stFINode *)malloc(sizeof(stFINode));
-                    if (node == NULL) {
-                        lErr("Allocate failed...");
-                        ret = -EFAULT;
+        view = (stFIHash *)malloc(sizeof(stFIHash));
+        if (view == NULL) {
+            lErr("Allocate failed...");
+        }
+        else if ( (view->slot = (stFINode **)calloc(size, sizeof(stFINode *))) == NULL ) {
+            lErr("Allocate failed...");
+            free(view);
+            view = NULL;
+        }
+        else {
+            view->mask  = size - 1;
+            view->count = 0;
+            view->flags = tree->flags;
+
+            for (walk = node; walk != NULL; walk = walk->parent) {
+                for (head = (walk->sect) ? walk->sect->hIni->head : NULL; head != NULL; head = head->next) {
+                    if (head->cfg.type == E_INI_T_PROPERTY) {
+                        fiHashAdd(view, head);
                     }
-                    else {
-                        node->cfg.type = E_INI_T_PROPERTY;
+                }
+            }
 
-                        node->value = fiProp;
-                        node->front = NULL;
-                        node->next  = NULL;
+            node->view = view;
+        }
+    }
 
-                        ret = fiInsertNode(fiSect->hIni, node);
-                    }
-                }
+    return node->view;
+}
 
-            }
-            else {
-                if (length > 1) {
-                    ptr = (char *)malloc(length);
-                    if (ptr == NULL) {
-                        lErr("Allocate failed...");
-                        ret = -EFAULT;
-                    }
-                    else {
-                        snprintf(ptr, length, "%s", value);
-                    }
-                }
+char *fiGetInherited(stFIHandle *hIni, const char *sect, const char *key)
+{
+    size_t size = 0;
 
-                if (fiProp->val) { free(fiProp->val); }
+    stFITree     *tree = NULL;
+    stFITreeNode *node = NULL;
+    stFIHash     *view = NULL;
+    stFINode     *prop = NULL;
 
-                fiProp->val = ptr;
-            }
+    if ( (hIni == NULL) || (sect == NULL) || (key == NULL) ) {
+        lWrn("Is Not exist handle!!!");
+    }
+    else if ( (tree = fiTreeGet(hIni)) != NULL ) {
+        node = fiTreeNearest(tree, sect, strlen(sect));
+        view = (node) ? fiTreeView(tree, node) : NULL;
+        if (view) {
+            size = strlen(key);
+            prop = fiHashFind(view, E_INI_T_PROPERTY, key, size, fiHashName(view->flags, key, size));
         }
     }
 
-    return ret;
+    return (prop) ? ((stFIProperty *)prop->value)->val : NULL;
 }
-
@@ -10,6 +10,11 @@
 #define _FILE_INI_HEADER
 
 #include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /** UTF-8 Description
  * +---------+----------------------+--------+---------+---------+---------+---------+---------+---------+
@@ -33,6 +38,30 @@
  * +---------+-----------+----------+--------+---------+---------+---------+---------+---------+---------+
  */
 
+typedef enum ENUM_INI_ORDER {
+    E_INI_O_NAME     = 0,  // bytewise file name order
+    E_INI_O_VERSION        // version order(strverscmp), 9-a.ini before 10-a.ini
+} enFIOrder;
+
+typedef enum ENUM_INI_VALUE {
+    E_INI_V_STRING   = 0,  // text only
+    E_INI_V_INT      ,     // strtoll() base 0
+    E_INI_V_DOUBLE   ,
+    E_INI_V_BOOL           // true/false, yes/no, on/off, 1/0
+} enFIValue;
+
+typedef enum ENUM_INI_DUPLICATE {
+    E_INI_D_FIRST    = 0,  // first value wins, later lines are kept but shadowed
+    E_INI_D_LAST     ,     // later value replaces the earlier one
+    E_INI_D_LIST           // values are joined with FI_LIST_SEPARATOR, one fiGetList() item per line
+} enFIDuplicate;
+
+typedef enum ENUM_INI_MERGE {
+    E_INI_M_OVERWRITE = 0, // values of src replace those of dst
+    E_INI_M_KEEP      ,    // values of dst are kept, only missing keys are added
+    E_INI_M_ERROR          // -EEXIST when a key has another value in dst, nothing is changed
+} enFIMerge;
+
 typedef enum ENUM_INI_TYPE {
     E_INI_T_BLANK    = 0,  // balnk link
     E_INI_T_COMMENT  ,     // comment(# or ;)
@@ -43,8 +72,7 @@ typedef enum ENUM_INI_TYPE {
 
 typedef struct STRUCT_INI_ELEMENT_CONFIG {
     uint32_t type    : 4; //  0: 3, Element node type
-    uint32_t size    :12; //  4:15, Element node data size(length)
-    uint32_t reserve :16;
+    uint32_t size    :28; //  4:31, Element node data size(length), up to 256 MiB - 1
 } stFIECfg;
 
 typedef struct STRUCT_INI_ELEMENT_NODE {
@@ -57,30 +85,322 @@ typedef struct STRUCT_INI_ELEMENT_NODE {
 typedef struct STRUCT_INI_HANDLE {
     stFINode  *head;
     stFINode  *tail;
+
+    struct STRUCT_INI_ORDER *order; // Sorted key index, built on first range query
+    struct STRUCT_INI_HASH  *hash;  // Section/key hash index, built once count reaches FI_HASH_MIN
+    size_t                   count; // Section or property nodes
+
+    struct STRUCT_INI_JOURNAL *journal; // fiJournalOpen(), fiPut() appends a record
+    struct STRUCT_INI_TREE    *tree;    // Dotted section hierarchy, FI_OPT_TREE or first tree query
+
+    uint32_t   flags;                // FI_OPT_NOCASE : hashes of names are fiHashFold()
+    uint64_t   epoch;                // Process unique, renewed on structural change
 } stFIHandle;
 
 typedef struct STRUCT_INI_PROPERTY {
-	char *key;
-	char *val;
+	char   *key;
+	char   *val;
+    size_t  lenKey;
+    size_t  lenVal;
+    uint32_t hash;     // fiHash() of the key
+
+    uint32_t                    version;  // Bumped on every value update
+    struct STRUCT_INI_RESOLVED *resolved; // fiGetResolved() cache
+    struct STRUCT_INI_LIST     *list;     // fiGetList() cache
+
+    int      type;     // enFIValue converted by a schema during the parse
+    union {
+        int64_t num;   // E_INI_V_INT, E_INI_V_BOOL
+        double  real;  // E_INI_V_DOUBLE
+    } typed;
 } stFIProperty;
 
 typedef struct STRUCT_INI_SECTION {
 	char       *name;
     stFIHandle *hIni;
+    size_t      lenName;
+    uint32_t    hash;    // fiHash() of the name
+    uint32_t    refs;    // Handles sharing this section(fiClone)
 } stFISection;
 
+/**
+ * Cursor over sections or keys. Lives on the caller stack, no heap allocation.
+ * Value updates through fiPut() keep the cursor valid; only the value span
+ * returned for the updated key becomes stale.
+ */
+typedef struct STRUCT_INI_ITERATOR {
+    stFINode   *node;   // next candidate node
+    void       *item;   // last returned section/property
+
+    stFIHandle *hIni;   // range cursor : section handle of the sorted key index
+    size_t      pos;    // range cursor : next index slot
+    size_t      end;    // range cursor : end index slot (exclusive)
+
+    struct STRUCT_INI_TREE_NODE *child; // child cursor : next child path
+} stFIIter;
+
 
 #define FI_LINE           "\r\n"
 #define FI_BUFFER_SIZE    4096
+#define FI_EXPORT_BUFFER  (64 * 1024)
+#define FI_HASH_MIN       8
+
+#define FI_TREE_SEPARATOR '.'
+#define FI_LIST_SEPARATOR ','
+#define FI_LIST_ESCAPE    '\\'
+
+#define FI_COMPACT_SUFFIX ".tmp"
+#define FI_JOURNAL_SUFFIX ".journal"
+#define FI_JOURNAL_SYNC   0x01 // fdatasync() after every record
+
+#define FI_CACHE_ENABLE   0x01 // fiFileRead() goes through the parse cache
+#define FI_CACHE_HASH     0x02 // Also compare a content hash, survives touch and coarse mtime
+#define FI_LOAD_THREADS   8
+
+/**
+ * Read-only image of a handle in POSIX shared memory.
+ * Data lives in "<name>.<generation>", the control segment "<name>" holds the
+ * current generation. A single publisher republishes by writing a new
+ * generation; readers pick it up with fiShmRefresh(), lookups take no lock.
+ */
+typedef struct STRUCT_INI_SHM stFIShm;
+
+#define FI_SCHEMA_REQUIRED 0x01 // stFISchemaEntry : violation when absent without default
+#define FI_SCHEMA_STRICT   0x01 // fiSchemaCompile() : undeclared sections and keys are violations
+
+typedef struct STRUCT_INI_SCHEMA_ENTRY {
+    const char *sect;
+    const char *key;     // NULL declares only the section(FI_SCHEMA_STRICT)
+    int         type;    // enFIValue
+    uint32_t    flags;   // FI_SCHEMA_*
+    const char *def;     // Inserted when the key is absent
+    double      min;     // Value range, string length for E_INI_V_STRING
+    double      max;     // min == max == 0 : unbounded
+} stFISchemaEntry;
+
+typedef struct STRUCT_INI_VIOLATION {
+    size_t      line;    // 1 based, 0 for keys missing from the input
+    int         error;   // -ENOENT missing, -EINVAL type, -ERANGE range, -EPERM undeclared
+    const char *sect;
+    const char *key;     // NULL for a section
+    const char *val;
+} stFIViolation;
+
+typedef struct STRUCT_INI_SCHEMA stFISchema;
+
+typedef struct STRUCT_INI_OPTION {
+    const stFISchema *schema;
+    void            (*report)(void *ctx, const stFIViolation *violation);
+    void             *ctx;
+
+    uint32_t          flags;      // FI_OPT_*
+    char              separator;  // FI_OPT_TREE, 0 : FI_TREE_SEPARATOR
+    int               duplicate;  // enFIDuplicate, repeated keys of a section
+
+    /* Parse limits for untrusted input, 0 : unlimited. Crossing one fails the parse with its error */
+    size_t            maxBytes;    // Input bytes,                -EFBIG
+    size_t            maxLine;     // Bytes of a line,            -EMSGSIZE
+    size_t            maxSections; // Sections,                   -ENOSPC
+    size_t            maxKeys;     // Properties of a section,    -EMLINK
+    size_t            maxHeap;     // Estimated bytes allocated,  -EDQUOT
+
+    size_t            violations; // out
+    int               error;      // out, the parse failed and returned NULL
+    size_t            offset;     // out, input byte offset of error, start of the line for line errors
+} stFIOption;
+
+/* A UTF-8 BOM at the start of the input is always skipped unless rejected */
+#define FI_OPT_TREE        0x01 // Build the section hierarchy while parsing
+#define FI_OPT_UTF8        0x02 // Invalid UTF-8 fails the parse with -EILSEQ at its first byte, ASCII is checked by block
+#define FI_OPT_BOM_REJECT  0x04 // A BOM fails the parse with -EBADMSG
+#define FI_OPT_NOCASE      0x08 // Handle ignores ASCII case of section and key names, kept by fiClone()
+
+typedef struct STRUCT_INI_SPAN {
+    const char *str;   // Not terminated
+    size_t      len;
+} stFISpan;
+
+typedef struct STRUCT_INI_EVENT {
+    int         type;    // enFIType
+    size_t      line;    // 1 based
+    stFISpan    sect;    // Current section, the new one for E_INI_T_SECTION
+    stFISpan    key;     // E_INI_T_PROPERTY
+    stFISpan    val;     // E_INI_T_PROPERTY value(unquoted), E_INI_T_COMMENT text
+} stFIEvent;
+
+/* NULL callbacks are skipped, a non zero result stops the parse */
+typedef struct STRUCT_INI_EVENTS {
+    int (*section)(void *ctx, const stFIEvent *ev);
+    int (*property)(void *ctx, const stFIEvent *ev);
+    int (*comment)(void *ctx, const stFIEvent *ev);
+    int (*blank)(void *ctx, const stFIEvent *ev);
+} stFIEvents;
+
+typedef struct STRUCT_INI_CACHE_STAT {
+    uint64_t hits;     // Served as a clone of the cached handle
+    uint64_t misses;   // Parsed, first read or changed file
+    size_t   entries;
+} stFICacheStat;
 
 stFIHandle *fiInit(void);
 void        fiDestroy(stFIHandle *hIni);
 void        fiShow(stFIHandle *hIni);
 
-stFIHandle *fiFileRead(const char *file);
+/**
+ * Copy-on-write clone. Sections are shared by reference count and copied
+ * into the clone on their first fiPut(); the clones may be destroyed in any order.
+ */
+stFIHandle *fiClone(stFIHandle *hIni);
+
+uint32_t    fiHash(const char *str, size_t size); // 32-bit FNV-1a
+uint32_t    fiHashFold(const char *str, size_t size); // fiHash() of the ASCII lower case form
+
+stFIHandle *fiFileRead(const char *file); // Replays file FI_JOURNAL_SUFFIX when it exists
+stFIHandle *fiFileReadOpt(const char *file, stFIOption *opt);
+
+/**
+ * Loads the regular files of a conf.d style directory matching pattern(fnmatch,
+ * NULL for all, hidden files and FI_JOURNAL_SUFFIX/FI_COMPACT_SUFFIX files skipped) on up to FI_LOAD_THREADS threads and merges
+ * them in enFIOrder file name order, keys of later files override earlier ones.
+ */
+stFIHandle *fiLoadDirectory(const char *path, const char *pattern, int order);
+
+/**
+ * Moves the content of src into dst with an enFIMerge policy, in O(n + m) through
+ * the hash indexes. Sections only in src are spliced, not copied; src is left empty
+ * but must still be destroyed. Merged keys are not journaled.
+ */
+int         fiMerge(stFIHandle *dst, stFIHandle *src, int policy);
+
+/**
+ * Process wide parse cache, keyed by (dev, inode) and checked against size and
+ * mtime(ns). A hit returns a fiClone() of the cached handle, so the result is
+ * still owned by the caller and may be changed with fiPut(). Shared sections
+ * are only read : fiPut() and the lazy caches of fiGetList(), fiGetResolved(),
+ * fiGetPrefix() and fiGetRange() copy a section into the handle first. Each
+ * clone may be used from its own thread, a single handle still needs a lock.
+ */
+int         fiCacheSetup(uint32_t flags); // 0 disables and flushes
+void        fiCacheFlush(void);
+void        fiCacheStat(stFICacheStat *stat);
 int         fiFileSave(const char *file, stFIHandle *hIni);
 
+stFIHandle *fiParseBuffer(const char *buf, size_t size);
+stFIHandle *fiParseFd(int fd);
+stFIHandle *fiParseBufferOpt(const char *buf, size_t size, stFIOption *opt);
+stFIHandle *fiParseFdOpt(int fd, stFIOption *opt);
+
+/**
+ * Streams fd, or buf when fd is -1, as events without building a tree. Spans
+ * are NUL terminated and valid during the callback only; memory stays bounded
+ * by the longest line. Returns 0 at the end of input, the non zero result of
+ * the callback that stopped it, or a negative errno.
+ */
+int         fiParseStream(int fd, const char *buf, size_t size, const stFIEvents *events, void *ctx);
+
+int         fiSaveToFd(int fd, stFIHandle *hIni);
+char       *fiSaveToBuffer(stFIHandle *hIni, size_t *size); // free() the result
+
+/**
+ * One pass exporters to fd through a FI_EXPORT_BUFFER sink, comments and blank
+ * lines are dropped and lines end with LF.
+ *  Json : {"key":"value","section":{"key":"value"}}, global keys at the top, no value as null,
+ *         bytes that are not valid UTF-8 as \ufffd
+ *  Env  : SECTION_KEY=value, names upper cased with other bytes as '_', values shell quoted.
+ *         Distinct keys may map to one name(a.b and a_b, k and K), the last line wins when sourced
+ *  Flat : section.key=value, values quoted as by fiSaveToFd()
+ */
+int         fiExportJson(int fd, stFIHandle *hIni);
+int         fiExportEnv(int fd, stFIHandle *hIni);
+int         fiExportFlat(int fd, stFIHandle *hIni);
+
+/**
+ * Journaled mode : every fiPut() appends a (section, key, value) record to
+ * file FI_JOURNAL_SUFFIX instead of rewriting the file. fiJournalCompact()
+ * saves the handle to file FI_COMPACT_SUFFIX, renames it over file and only
+ * then empties the journal. Replay is read only, a torn tail is ignored there
+ * and cut by fiJournalOpen(). Writers and compaction hold flock(LOCK_EX).
+ */
+int         fiJournalOpen(stFIHandle *hIni, const char *file, uint32_t flags);
+int         fiJournalCompact(stFIHandle *hIni);
+void        fiJournalClose(stFIHandle *hIni);
+
+int         fiShmPublish(const char *name, stFIHandle *hIni);
+int         fiShmUnlink(const char *name);
+stFIShm    *fiShmAttach(const char *name);
+void        fiShmDetach(stFIShm *shm);
+int         fiShmRefresh(stFIShm *shm);  // 1 : new generation mapped, old pointers are invalid
+uint64_t    fiShmGeneration(stFIShm *shm);
+const char *fiShmGet(stFIShm *shm, const char *sect, const char *key);
+
 char *fiGet(stFIHandle *hIni, const char *sect, const char *key);
+
+/**
+ * Value with ${section:key}, ${key}(same section) and ${ENV:VAR} expanded, "$$" is a '$'.
+ * Missing references expand to nothing, a reference cycle returns NULL.
+ * The result is cached on the property until a value it depends on changes and
+ * stays valid until the next fiPut() or fiGetResolved() of that key, through this
+ * handle or a clone sharing its section. ${ENV:VAR} is read when the value is resolved.
+ */
+char *fiGetResolved(stFIHandle *hIni, const char *sect, const char *key);
 int   fiPut(stFIHandle *hIni, const char *sect, const char *key, const char *value);
 
+/**
+ * Lookup by (pointer, length) with hashes computed by the caller, e.g. at compile time.
+ * fiHash() values, or fiHashFold() ones when the handle has FI_OPT_NOCASE.
+ */
+stFIProperty *fiLookup(stFIHandle *hIni, const char *sect, size_t lenSect, uint32_t hashSect,
+                       const char *key, size_t lenKey, uint32_t hashKey);
+
+/**
+ * Items of a FI_LIST_SEPARATOR separated value, blanks around items trimmed.
+ * FI_LIST_ESCAPE before a separator or itself keeps it in the item, E_INI_D_LIST
+ * escapes both when it joins duplicate lines so each line stays a single item.
+ * The spans are split once per value and stay valid until the next fiPut() of the key.
+ */
+int   fiGetList(stFIHandle *hIni, const char *sect, const char *key, const stFISpan **list, size_t *count);
+
+/* Typed getters use the value converted by the schema, else convert the text. Integers are decimal or 0x hex */
+int   fiValueParse(int type, const char *val, int64_t *num, double *real);
+int   fiGetInt(stFIHandle *hIni, const char *sect, const char *key, int64_t *value);
+int   fiGetDouble(stFIHandle *hIni, const char *sect, const char *key, double *value);
+int   fiGetBool(stFIHandle *hIni, const char *sect, const char *key, int *value);
+
+/**
+ * Compiles declared sections and keys into a hash table. Passed in stFIOption,
+ * the parse validates and converts each value as it is read and reports every
+ * violation with its line number.
+ */
+stFISchema *fiSchemaCompile(const stFISchemaEntry *entry, size_t count, uint32_t flags);
+void        fiSchemaDestroy(stFISchema *schema);
+
+int fiSectionIter(stFIHandle *hIni, stFIIter *iter);
+int fiSectionNext(stFIIter *iter, const char **name, size_t *len);
+int fiSectionKeys(const stFIIter *sectIter, stFIIter *iter);
+int fiKeyIter(stFIHandle *hIni, const char *sect, stFIIter *iter);
+int fiKeyNext(stFIIter *iter, const char **key, size_t *lenKey, const char **val, size_t *lenVal);
+
+/**
+ * Sections as a tree, "server.http.tls" under "server.http" under "server".
+ * A path with no section of its own is still enumerated, fiSectionKeys() on
+ * it returns -ENOENT. The tree and the per section inherited key tables are
+ * rebuilt on the first query after fiPut() adds a key or copies a section.
+ */
+int         fiTreeBuild(stFIHandle *hIni, char separator);
+const char *fiSectionParent(stFIHandle *hIni, const char *sect); // Nearest existing ancestor
+int         fiSectionChildren(stFIHandle *hIni, const char *sect, stFIIter *iter); // "" : top level, fiSectionNext()
+char       *fiGetInherited(stFIHandle *hIni, const char *sect, const char *key); // sect, else nearest ancestor
+
+/**
+ * Range cursors over the sorted key index of a section, consumed with fiKeyNext().
+ * Keys are ordered bytewise; fiGetRange() covers [first, last), NULL is unbounded.
+ * Adding keys while a range cursor is open is not reflected in that cursor.
+ */
+int fiGetPrefix(stFIHandle *hIni, const char *sect, const char *prefix, stFIIter *iter);
+int fiGetRange(stFIHandle *hIni, const char *sect, const char *first, const char *last, stFIIter *iter);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _FILE_INI_HEADER */
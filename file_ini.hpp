@@ -0,0 +1,201 @@
+/**
+* @file file_ini.hpp
+* @brief This file declares C++17 wrapper of ini file handle
+* @author yikim
+* @version 1.0
+* @date 2014-12-10
+*/
+
+#ifndef _FILE_INI_HPP_HEADER
+#define _FILE_INI_HPP_HEADER
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "file_ini.h"
+
+namespace fi {
+
+/* Same 32-bit FNV-1a as fiHash(), usable at compile time */
+constexpr uint32_t hash(std::string_view str) noexcept
+{
+    uint32_t value = 0x811C9DC5;
+
+    for (char ch : str) {
+        value = (value ^ static_cast<uint8_t>(ch)) * 0x01000193;
+    }
+
+    return value;
+}
+
+/* Same as fiHashFold() */
+constexpr uint32_t hashFold(std::string_view str) noexcept
+{
+    uint32_t value = 0x811C9DC5;
+
+    for (char ch : str) {
+        value = (value ^ static_cast<uint8_t>((ch >= 'A' && ch <= 'Z') ? (ch | 0x20) : ch)) * 0x01000193;
+    }
+
+    return value;
+}
+
+/* Section or key name with its hashes, a literal is hashed at compile time */
+struct Name {
+    std::string_view str;
+    uint32_t         hash;
+    uint32_t         fold;   // FI_OPT_NOCASE handles
+
+    constexpr Name(const char *name) noexcept : Name(std::string_view(name)) {}
+    constexpr Name(std::string_view name) noexcept : str(name), hash(fi::hash(name)), fold(fi::hashFold(name)) {}
+
+    constexpr uint32_t of(const stFIHandle *hIni) const noexcept { return (hIni->flags & FI_OPT_NOCASE) ? fold : hash; }
+};
+
+/* constexpr Key kPort{"net", "port"}; probes the hash indexes without hashing at run time */
+struct Key {
+    Name sect;
+    Name key;
+
+    constexpr Key(Name s, Name k) noexcept : sect(s), key(k) {}
+};
+
+class File {
+public:
+    File() noexcept = default;
+    explicit File(stFIHandle *hIni) noexcept : hIni_(hIni) {}
+    ~File() { reset(); }
+
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+
+    File(File &&other) noexcept : hIni_(other.release()) {}
+    File &operator=(File &&other) noexcept
+    {
+        if (this != &other) {
+            reset(other.release());
+        }
+        return *this;
+    }
+
+    static File read(const char *path) { return File(fiFileRead(path)); }
+    static File parse(std::string_view buf) { return File(fiParseBuffer(buf.data(), buf.size())); }
+
+    File clone() const { return File(hIni_ ? fiClone(hIni_) : nullptr); }
+
+    explicit operator bool() const noexcept { return hIni_ != nullptr; }
+    stFIHandle *handle() const noexcept { return hIni_; }
+
+    stFIHandle *release() noexcept { return std::exchange(hIni_, nullptr); }
+    void reset(stFIHandle *hIni = nullptr) noexcept
+    {
+        if (hIni_) {
+            fiDestroy(hIni_);
+        }
+        hIni_ = hIni;
+    }
+
+    const stFIProperty *find(const Key &key) const noexcept
+    {
+        return hIni_ ? fiLookup(hIni_, key.sect.str.data(), key.sect.str.size(), key.sect.of(hIni_),
+                                key.key.str.data(), key.key.str.size(), key.key.of(hIni_))
+                     : nullptr;
+    }
+
+    bool contains(const Key &key) const noexcept { return find(key) != nullptr; }
+
+    /* Empty view for a missing key, valid until the key is changed */
+    std::string_view get(const Key &key) const noexcept
+    {
+        const stFIProperty *prop = find(key);
+
+        return (prop && prop->val) ? std::string_view(prop->val, prop->lenVal) : std::string_view();
+    }
+
+    std::string_view get(Name sect, Name key) const noexcept { return get(Key(sect, key)); }
+
+    /* int/long types, double, bool or std::string_view */
+    template <typename T>
+    std::optional<T> get(const Key &key) const
+    {
+        const stFIProperty *prop = find(key);
+
+        int64_t num  = 0;
+        double  real = 0.0;
+
+        if (prop == nullptr) {
+            return std::nullopt;
+        }
+
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return (prop->val) ? std::string_view(prop->val, prop->lenVal) : std::string_view();
+        }
+        else if constexpr (std::is_same_v<T, bool>) {
+            if (typed(prop, E_INI_V_BOOL, num, real)) { return num != 0; }
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            if (typed(prop, E_INI_V_INT, num, real) && fits<T>(num)) { return static_cast<T>(num); }
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            if (typed(prop, E_INI_V_DOUBLE, num, real)
+             && (!std::isfinite(real) || std::fabs(real) <= static_cast<double>(std::numeric_limits<T>::max()))) {
+                return static_cast<T>(real);
+            }
+        }
+        else {
+            static_assert(std::is_same_v<T, void>, "fi::File::get<T>() unsupported type");
+        }
+
+        return std::nullopt;
+    }
+
+    template <typename T>
+    std::optional<T> get(Name sect, Name key) const { return get<T>(Key(sect, key)); }
+
+    int put(std::string_view sect, std::string_view key, std::string_view value)
+    {
+        return hIni_ ? fiPut(hIni_, std::string(sect).c_str(), std::string(key).c_str(), std::string(value).c_str())
+                     : -EINVAL;
+    }
+
+    int save(const char *path) const { return hIni_ ? fiFileSave(path, hIni_) : -EINVAL; }
+
+private:
+    /* Out of range values are missing rather than wrapped */
+    template <typename T>
+    static constexpr bool fits(int64_t num) noexcept
+    {
+        if constexpr (std::is_signed_v<T>) {
+            return (num >= static_cast<int64_t>(std::numeric_limits<T>::min()))
+                && (num <= static_cast<int64_t>(std::numeric_limits<T>::max()));
+        }
+        else {
+            return (num >= 0) && (static_cast<uint64_t>(num) <= static_cast<uint64_t>(std::numeric_limits<T>::max()));
+        }
+    }
+
+    /* Only the union member of the converted type is read */
+    static bool typed(const stFIProperty *prop, int type, int64_t &num, double &real) noexcept
+    {
+        if (prop->type == type) {
+            if (type == E_INI_V_DOUBLE) { real = prop->typed.real; }
+            else                        { num  = prop->typed.num;  }
+            return true;
+        }
+
+        return fiValueParse(type, prop->val, &num, &real) == 0;
+    }
+
+    stFIHandle *hIni_ = nullptr;
+};
+
+} // namespace fi
+
+#endif /* _FILE_INI_HPP_HEADER */
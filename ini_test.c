@@ -1,17 +1,249 @@
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "file_ini.h"
 
+#define TEST(cond)                                                      \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("FAIL %s:%d %s\n", __func__, __LINE__, #cond);       \
+            fails = fails + 1;                                          \
+        }                                                               \
+    } while (0)
+
+static int fails = 0;
+
 void usage(const char *file)
 {
     printf("%s [ini]\n", file);
+    printf("%s -t [dir] : self test, files are written to dir(/tmp)\n", file);
+}
+
+int testWrite(const char *file, const char *text)
+{
+    int ret = 0;
+
+    FILE *fp = NULL;
+
+    fp = fopen(file, "w");
+    if (fp == NULL) {
+        ret = -errno;
+    }
+    else {
+        fputs(text, fp);
+        fclose(fp);
+    }
+
+    return ret;
+}
+
+/* A record cut by a crash is ignored by readers and trimmed by the next owner */
+void testJournalTorn(const char *dir)
+{
+    char file[256],
+         journal[256 + sizeof(FI_JOURNAL_SUFFIX)];
+
+    int fd = -1;
+
+    off_t size = 0;
+
+    stFIHandle *hIni = NULL;
+
+    snprintf(file, sizeof(file), "%s/ini_test_journal.ini", dir);
+    snprintf(journal, sizeof(journal), "%s%s", file, FI_JOURNAL_SUFFIX);
+    unlink(journal);
+    TEST(testWrite(file, "[s]\nk = 1\nj = 1\n") == 0);
+
+    hIni = fiFileRead(file);
+    TEST(hIni != NULL);
+    TEST(fiJournalOpen(hIni, file, 0) == 0);
+    TEST(fiPut(hIni, "s", "k", "2") == 0);
+    TEST(fiPut(hIni, "s", "j", "2") == 0);
+    fiDestroy(hIni);
+
+    // Cut the last record in the middle
+    fd = open(journal, O_RDWR);
+    TEST(fd >= 0);
+    size = lseek(fd, 0, SEEK_END);
+    TEST(ftruncate(fd, size - 3) == 0);
+    close(fd);
+
+    hIni = fiFileRead(file);
+    TEST(hIni != NULL);
+    TEST(strcmp(fiGet(hIni, "s", "k"), "2") == 0);
+    TEST(strcmp(fiGet(hIni, "s", "j"), "1") == 0);
+    TEST(fiJournalOpen(hIni, file, 0) == 0);
+    TEST(fiPut(hIni, "s", "j", "3") == 0);
+    fiDestroy(hIni);
+
+    hIni = fiFileRead(file);
+    TEST(hIni != NULL);
+    TEST(strcmp(fiGet(hIni, "s", "k"), "2") == 0);
+    TEST(strcmp(fiGet(hIni, "s", "j"), "3") == 0);
+    fiDestroy(hIni);
+
+    unlink(journal);
+    unlink(file);
+}
+
+/* fiPut() on a clone copies the shared section, the source keeps its values */
+void testClone(void)
+{
+    const char *text = "[s]\nk = 1\nlist = a, b\n[t]\nk = 1\n";
+
+    const stFISpan *list  = NULL;
+    size_t          count = 0;
+
+    stFIHandle *hIni  = NULL,
+               *clone = NULL;
+
+    hIni = fiParseBuffer(text, strlen(text));
+    TEST(hIni != NULL);
+    clone = fiClone(hIni);
+    TEST(clone != NULL);
+
+    TEST(fiPut(clone, "s", "k", "2") == 0);
+    TEST(fiPut(clone, "u", "k", "3") == 0);
+    TEST(strcmp(fiGet(clone, "s", "k"), "2") == 0);
+    TEST(strcmp(fiGet(hIni, "s", "k"), "1") == 0);
+    TEST(fiGet(hIni, "u", "k") == NULL);
+
+    TEST(fiGetList(clone, "t", "k", &list, &count) == 0);
+    TEST(fiGetList(hIni, "s", "list", &list, &count) == 0);
+    TEST(count == 2);
+
+    // Clones may be destroyed in any order
+    fiDestroy(hIni);
+    TEST(strcmp(fiGet(clone, "s", "list"), "a, b") == 0);
+    TEST(strcmp(fiGet(clone, "t", "k"), "1") == 0);
+    fiDestroy(clone);
+}
+
+/* E_INI_D_LIST keeps each duplicate line a single fiGetList() item */
+void testList(void)
+{
+    const char *text = "[s]\na = 1,2\na = 3\nb = x, y\n";
+
+    const stFISpan *list  = NULL;
+    size_t          count = 0;
+
+    stFIOption  opt;
+    stFIHandle *hIni = NULL;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.duplicate = E_INI_D_LIST;
+
+    hIni = fiParseBufferOpt(text, strlen(text), &opt);
+    TEST(hIni != NULL);
+
+    TEST(fiGetList(hIni, "s", "a", &list, &count) == 0);
+    TEST(count == 2);
+    TEST( (count == 2) && (list[0].len == 3) && (memcmp(list[0].str, "1,2", 3) == 0) );
+    TEST( (count == 2) && (list[1].len == 1) && (list[1].str[0] == '3') );
+
+    TEST(fiGetList(hIni, "s", "b", &list, &count) == 0);
+    TEST(count == 2);
+
+    fiDestroy(hIni);
+}
+
+/* Each limit fails the parse with its errno at the start of the offending line */
+void testLimitOne(const char *text, stFIOption *opt, int error, size_t offset)
+{
+    stFIHandle *hIni = NULL;
+
+    hIni = fiParseBufferOpt(text, strlen(text), opt);
+    TEST(hIni == NULL);
+    TEST(opt->error == error);
+    TEST(opt->offset == offset);
+    if (hIni) { fiDestroy(hIni); }
+}
+
+void testLimits(void)
+{
+    const char *text = "[a]\nk = 1\nj = 2\n[b]\nlongkey = 12345\n";
+
+    stFIOption opt;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.maxBytes = 16;
+    testLimitOne(text, &opt, -EFBIG, 16);
+
+    memset(&opt, 0, sizeof(opt));
+    opt.maxLine = 10;
+    testLimitOne(text, &opt, -EMSGSIZE, 20);
+
+    memset(&opt, 0, sizeof(opt));
+    opt.maxSections = 1;
+    testLimitOne(text, &opt, -ENOSPC, 16);
+
+    memset(&opt, 0, sizeof(opt));
+    opt.maxKeys = 1;
+    testLimitOne(text, &opt, -EMLINK, 10);
+
+    memset(&opt, 0, sizeof(opt));
+    opt.maxHeap = 1;
+    testLimitOne(text, &opt, -EDQUOT, 0);
+}
+
+/* JSON strings escape quotes and control bytes, valid UTF-8 is kept and each invalid byte is \ufffd */
+void testJson(const char *dir)
+{
+    const char *expect = "{\"s\":{\"k\":\"q\\\"b\\\\n\\n\\u0001\xc3\xbf\\ufffd\\ufffd\\ufffdz\xc3\xa9\"}}\n";
+
+    char file[256],
+         buf[256];
+
+    int fd = -1;
+
+    ssize_t size = 0;
+
+    stFIHandle *hIni = NULL;
+
+    snprintf(file, sizeof(file), "%s/ini_test.json", dir);
+
+    hIni = fiInit();
+    TEST(hIni != NULL);
+    TEST(fiPut(hIni, "s", "k", "q\"b\\n\n\x01\xc3\xbf\xff\xe0\x80z\xc3\xa9") == 0);
+
+    fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    TEST(fd >= 0);
+    TEST(fiExportJson(fd, hIni) == 0);
+    size = pread(fd, buf, sizeof(buf) - 1, 0);
+    TEST(size > 0);
+    buf[(size > 0) ? size : 0] = '\0';
+    TEST(strcmp(buf, expect) == 0);
+    close(fd);
+
+    fiDestroy(hIni);
+    unlink(file);
+}
+
+int testRun(const char *dir)
+{
+    testJournalTorn(dir);
+    testClone();
+    testList();
+    testLimits();
+    testJson(dir);
+
+    printf("%s\n", (fails) ? "FAIL" : "OK");
+
+    return (fails) ? 1 : 0;
 }
 
 int main(int argc, char **argv)
 {
     stFIHandle *hIni = NULL;
 
-    if (argc > 1) {
+    if ( (argc > 1) && (strcmp(argv[1], "-t") == 0) ) {
+        return testRun((argc > 2) ? argv[2] : "/tmp");
+    }
+    else if (argc > 1) {
         hIni = (stFIHandle *)fiFileRead(argv[1]);
         if (hIni) {
 //              fiPut(hIni, "TEST", "T1", "1");
@@ -29,4 +261,3 @@ int main(int argc, char **argv)
 
     return 0;
 }
-